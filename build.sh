@@ -1,2 +1,2 @@
 #!/bin/sh
-g++ -o maze -O3 src/main.cpp imgui/*.cpp tinyfiledialogs/tinyfiledialogs.c -lGL -lGLEW -lglfw
\ No newline at end of file
+g++ -o maze -O3 src/main.cpp imgui/*.cpp tinyfiledialogs/tinyfiledialogs.c -lGL -lGLEW -lglfw -pthread
\ No newline at end of file
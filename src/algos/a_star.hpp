@@ -15,11 +15,24 @@ struct a_star : solution_interface {
 		std::priority_queue<node_t, std::vector<node_t>, std::greater<node_t>> priority_queue;
 		std::vector<point_t> previous(maze.width * maze.height, { -1, -1 });
 		std::vector<unsigned> distances(maze.width * maze.height, UINT_MAX);
+		const auto goals = maze.goals();
+		std::vector<bool> is_goal(maze.width * maze.height, false);
+		for (const auto& goal : goals) is_goal[idx(goal)] = true;
 
-		distances[idx(maze.start)] = 0;
-		priority_queue.push({ maze.start, 0, (unsigned)abs(maze.start.x - maze.end.x) + (unsigned)abs(maze.start.y - maze.end.y) });
+		//with several goals the heuristic is the manhattan distance to the nearest one, which stays admissible
+		std::vector<unsigned> goal_distances;
+		if (goals.size() > 1) goal_distances = manhattan_distance_transform(maze, goals);
+		auto heuristic = [&](const point_t& p) {
+			return goals.size() > 1 ? goal_distances[idx(p)] : (unsigned)abs(p.x - goals[0].x) + (unsigned)abs(p.y - goals[0].y);
+		};
+
+		for (const auto& source : maze.sources()) {
+			distances[idx(source)] = 0;
+			priority_queue.push({ source, 0, heuristic(source) });
+		}
 
 		auto completed = false;
+		auto reached = maze.end;
 
 		while (!priority_queue.empty()) {
 			auto current = priority_queue.top();
@@ -28,32 +41,54 @@ struct a_star : solution_interface {
 			if (current.distance > distances[idx(current.pos)])
 				continue;
 
-			if (!maze.grid[idx(current.pos)])
+			if (!maze.grid[current.pos])
 				continue;
 
-			if (current.pos == maze.end) {
+			if (is_goal[idx(current.pos)]) {
+				reached = current.pos;
 				completed = true;
 				break;
 			}
 
 			for (const auto& v : current.pos.neighbours(maze.width, maze.height)) {
-				if (!maze.grid[idx(v)]) continue;
+				if (!maze.grid[v]) continue;
 				const auto new_distance = distances[idx(current.pos)] + 1;
 				if (new_distance < distances[idx(v)]) {
 					distances[idx(v)] = new_distance;
 					previous[idx(v)] = current.pos;
-					priority_queue.push({ v, new_distance, new_distance + abs(v.x - maze.end.x) + abs(v.y - maze.end.y) });
+					priority_queue.push({ v, new_distance, new_distance + heuristic(v) });
 				}
 			}
 		}
 
 		std::deque<point_t> path;
-		auto current = maze.end;
+		auto current = reached;
 		while (!(current == point_t{ -1, -1 })) {
 			path.push_front(current);
 			current = previous[idx(current)];
 		}
 
-		return { completed, distances, std::vector<point_t>(path.begin(), path.end()) };
+		return { completed, distances, std::vector<point_t>(path.begin(), path.end()), path.front(), reached };
+	}
+
+private:
+	//exact manhattan distance from every cell to the nearest target, ignoring walls: two sweeps, one per diagonal direction
+	static std::vector<unsigned> manhattan_distance_transform(const maze_t& maze, const std::vector<point_t>& targets) {
+		const int width = maze.width, height = maze.height;
+		std::vector<unsigned> out(maze.width * maze.height, UINT_MAX - 1);
+		for (const auto& target : targets) out[target.y * width + target.x] = 0;
+		for (int y = 0; y < height; ++y)
+			for (int x = 0; x < width; ++x) {
+				auto& d = out[y * width + x];
+				if (x > 0) d = std::min(d, out[y * width + x - 1] + 1);
+				if (y > 0) d = std::min(d, out[(y - 1) * width + x] + 1);
+			}
+		for (int y = height - 1; y >= 0; --y)
+			for (int x = width - 1; x >= 0; --x) {
+				auto& d = out[y * width + x];
+				if (x + 1 < width) d = std::min(d, out[y * width + x + 1] + 1);
+				if (y + 1 < height) d = std::min(d, out[(y + 1) * width + x] + 1);
+			}
+		return out;
 	}
 };
\ No newline at end of file
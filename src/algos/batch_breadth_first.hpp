@@ -0,0 +1,144 @@
+#pragma once
+#include "../includes.hpp"
+
+struct query_t { point_t start, end; };
+
+struct batch_ret_t {
+	bool solved;
+	unsigned distance;
+	std::vector<point_t> path;
+};
+
+//answers many (start, end) queries on one maze with a multi-source bfs: every distinct start gets one bit of
+//a 64-bit word per cell, so one level-synchronous sweep advances up to 64 searches at once
+struct batch_breadth_first {
+	std::vector<batch_ret_t> solve(const maze_t& maze, const std::vector<query_t>& queries, const bool want_paths = false) {
+		const size_t width = maze.width, cells = size_t(maze.width) * maze.height;
+		auto idx = [&maze](const point_t& p) { return size_t(p.y) * maze.width + p.x; };
+		auto open = [&maze](const point_t& p) {
+			return p.x >= 0 && p.y >= 0 && p.x < int(maze.width) && p.y < int(maze.height) && maze.grid[p];
+		};
+
+		std::vector<batch_ret_t> out(queries.size(), { false, UINT_MAX, {} });
+
+		std::vector<size_t> sources; //distinct open start cells, sorted so a query finds its bit with a binary search
+		for (const auto& query : queries)
+			if (open(query.start) && open(query.end))
+				sources.push_back(idx(query.start));
+		std::sort(sources.begin(), sources.end());
+		sources.erase(std::unique(sources.begin(), sources.end()), sources.end());
+
+		std::vector<std::pair<size_t, size_t>> ends; //(end cell, query) sorted by cell, resolved when the cell is reached
+		std::vector<bool> is_end(cells, false);
+
+		std::vector<uint64_t> visited(cells), next(cells);
+		std::vector<uint64_t> mod3_lo, mod3_hi; //distance % 3 per source bit, enough to walk a path back
+		if (want_paths) {
+			mod3_lo.resize(cells);
+			mod3_hi.resize(cells);
+		}
+		std::vector<std::pair<size_t, uint64_t>> frontier;
+		std::vector<size_t> next_cells;
+
+		for (size_t first = 0; first < sources.size(); first += 64) {
+			const auto last = std::min(first + 64, sources.size());
+			auto bit_of = [&](const size_t cell) {
+				return uint64_t(1) << (std::lower_bound(sources.begin() + first, sources.begin() + last, cell) - sources.begin() - first);
+			};
+
+			ends.clear();
+			for (size_t i = 0; i < queries.size(); ++i) {
+				if (!open(queries[i].start) || !open(queries[i].end)) continue;
+				const auto source = idx(queries[i].start);
+				if (source < sources[first] || source > sources[last - 1]) continue;
+				if (queries[i].start == queries[i].end) {
+					out[i] = { true, 0, want_paths ? std::vector<point_t>{ queries[i].start } : std::vector<point_t>{} };
+					continue;
+				}
+				ends.push_back({ idx(queries[i].end), i });
+				is_end[idx(queries[i].end)] = true;
+			}
+			std::sort(ends.begin(), ends.end());
+			auto remaining = ends.size();
+
+			for (auto i = first; i < last; ++i) {
+				visited[sources[i]] |= uint64_t(1) << (i - first);
+				frontier.push_back({ sources[i], uint64_t(1) << (i - first) });
+			}
+
+			for (unsigned level = 1; !frontier.empty() && remaining; ++level) {
+				for (const auto& entry : frontier) {
+					const auto cell = entry.first;
+					const auto mask = entry.second;
+					const auto x = cell % width, y = cell / width;
+					auto visit = [&](const size_t n, const size_t nx, const size_t ny) {
+						if (!maze.grid.at(nx, ny)) return;
+						const auto fresh = mask & ~visited[n];
+						if (!fresh) return;
+						if (!next[n]) next_cells.push_back(n);
+						next[n] |= fresh;
+						visited[n] |= fresh;
+					};
+					if (x + 1 < width) visit(cell + 1, x + 1, y);
+					if (y + 1 < maze.height) visit(cell + width, x, y + 1);
+					if (x >= 1) visit(cell - 1, x - 1, y);
+					if (y >= 1) visit(cell - width, x, y - 1);
+				}
+
+				frontier.clear();
+				for (const auto n : next_cells) {
+					if (want_paths) {
+						if ((level % 3) & 1) mod3_lo[n] |= next[n];
+						if ((level % 3) & 2) mod3_hi[n] |= next[n];
+					}
+					if (is_end[n]) {
+						for (auto it = std::lower_bound(ends.begin(), ends.end(), std::make_pair(n, size_t(0))); it != ends.end() && it->first == n; ++it) {
+							if (out[it->second].solved || !(next[n] & bit_of(idx(queries[it->second].start)))) continue;
+							out[it->second] = { true, level, {} };
+							--remaining;
+						}
+					}
+					frontier.push_back({ n, next[n] });
+					next[n] = 0;
+				}
+				next_cells.clear();
+			}
+
+			if (want_paths) {
+				for (const auto& entry : ends) {
+					const auto query = entry.second;
+					if (!out[query].solved) continue;
+					const auto bit = bit_of(idx(queries[query].start));
+					auto mod3 = [&](const size_t n) { return ((mod3_lo[n] & bit) ? 1 : 0) | ((mod3_hi[n] & bit) ? 2 : 0); };
+
+					//neighbouring distances differ by at most one, so the neighbour seen by this source with distance
+					//one less (mod 3) is exactly one step closer to the start
+					auto& path = out[query].path;
+					path.resize(out[query].distance + 1);
+					auto current = queries[query].end;
+					for (auto d = out[query].distance; d > 0; --d) {
+						path[d] = current;
+						for (const auto& v : current.neighbours(maze.width, maze.height)) {
+							if ((visited[idx(v)] & bit) && mod3(idx(v)) == int((d - 1) % 3)) {
+								current = v;
+								break;
+							}
+						}
+					}
+					path[0] = current;
+				}
+			}
+
+			for (const auto& end : ends) is_end[end.first] = false;
+			frontier.clear();
+			next_cells.clear();
+			std::fill(visited.begin(), visited.end(), 0);
+			if (want_paths) {
+				std::fill(mod3_lo.begin(), mod3_lo.end(), 0);
+				std::fill(mod3_hi.begin(), mod3_hi.end(), 0);
+			}
+		}
+
+		return out;
+	}
+};
@@ -9,27 +9,33 @@ struct breadth_first : solution_interface {
 		std::vector<point_t> previous(maze.width * maze.height, { -1, -1 });
 		std::vector<bool> visited(maze.width * maze.height, false);
 		std::vector<unsigned> distances(maze.width * maze.height, UINT_MAX);
+		std::vector<bool> is_goal(maze.width * maze.height, false);
+		for (const auto& goal : maze.goals()) is_goal[idx(goal)] = true;
 
-		queue.push(maze.start);
-		distances[idx(maze.start)] = 0;
-		visited[idx(maze.start)] = true;
+		for (const auto& source : maze.sources()) {
+			queue.push(source);
+			distances[idx(source)] = 0;
+			visited[idx(source)] = true;
+		}
 
 		auto completed = false;
+		auto reached = maze.end;
 
 		while (!queue.empty()) {
 			const auto current = queue.front();
 			queue.pop();
 
-			if (!maze.grid[idx(current)])
+			if (!maze.grid[current])
 				continue;
 
-			if (current == maze.end) {
+			if (is_goal[idx(current)]) {
+				reached = current;
 				completed = true;
 				break;
 			}
 
 			for (const auto& v : current.neighbours(maze.width, maze.height)) {
-				if (!maze.grid[idx(v)]) continue;
+				if (!maze.grid[v]) continue;
 				if (!visited[idx(v)]) {
 					queue.push(v);
 					distances[idx(v)] = distances[idx(current)] + 1;
@@ -40,12 +46,12 @@ struct breadth_first : solution_interface {
 		}
 
 		std::deque<point_t> path;
-		auto current = maze.end;
+		auto current = reached;
 		while (!(current == point_t{ -1, -1 })) {
 			path.push_front(current);
 			current = previous[idx(current)];
 		}
 
-		return { completed, distances, std::vector<point_t>(path.begin(), path.end()) };
+		return { completed, distances, std::vector<point_t>(path.begin(), path.end()), path.front(), reached };
 	}
 };
\ No newline at end of file
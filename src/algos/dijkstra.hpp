@@ -14,11 +14,16 @@ struct dijkstra : solution_interface {
 		std::priority_queue<node_t, std::vector<node_t>, std::greater<node_t>> priority_queue;
 		std::vector<point_t> previous(maze.width * maze.height, { -1, -1 });
 		std::vector<unsigned> distances(maze.width * maze.height, UINT_MAX);
+		std::vector<bool> is_goal(maze.width * maze.height, false);
+		for (const auto& goal : maze.goals()) is_goal[idx(goal)] = true;
 
-		distances[idx(maze.start)] = 0;
-		priority_queue.push({ maze.start, 0, });
+		for (const auto& source : maze.sources()) {
+			distances[idx(source)] = 0;
+			priority_queue.push({ source, 0, });
+		}
 
 		auto completed = false;
+		auto reached = maze.end;
 
 		while (!priority_queue.empty()) {
 			auto current = priority_queue.top();
@@ -27,16 +32,17 @@ struct dijkstra : solution_interface {
 			if (current.distance > distances[idx(current.pos)])
 				continue;
 
-			if (!maze.grid[idx(current.pos)])
+			if (!maze.grid[current.pos])
 				continue;
 
-			if (current.pos == maze.end) {
+			if (is_goal[idx(current.pos)]) {
+				reached = current.pos;
 				completed = true;
 				break;
 			}
 
 			for (const auto& v : current.pos.neighbours(maze.width, maze.height)) {
-				if (!maze.grid[idx(v)]) continue;
+				if (!maze.grid[v]) continue;
 				const auto new_distance = distances[idx(current.pos)] + 1;
 				if (new_distance < distances[idx(v)]) {
 					distances[idx(v)] = new_distance;
@@ -47,12 +53,12 @@ struct dijkstra : solution_interface {
 		}
 
 		std::deque<point_t> path;
-		auto current = maze.end;
+		auto current = reached;
 		while (!(current == point_t{ -1, -1 })) {
 			path.push_front(current);
 			current = previous[idx(current)];
 		}
 
-		return { completed, distances, std::vector<point_t>(path.begin(), path.end()) };
+		return { completed, distances, std::vector<point_t>(path.begin(), path.end()), path.front(), reached };
 	}
 };
\ No newline at end of file
@@ -0,0 +1,106 @@
+#pragma once
+#include "../includes.hpp"
+#include <fstream>
+
+//distance to the nearest target for every open cell, plus the direction of the step towards it, so any number of
+//agents can follow the field without searching
+struct distance_field_t {
+	unsigned width = 0, height = 0;
+	std::vector<uint16_t> distances16; //only one of the two is filled, 16-bit whenever every distance fits
+	std::vector<uint32_t> distances32;
+	std::vector<uint8_t> directions; //4 bits per cell, 2 cells per byte, low nibble first: a step or one of the codes below
+
+	//0 = +x, 1 = +y, 2 = -x, 3 = -y step towards the nearest target; a target itself, or a wall or unreachable cell,
+	//has its own code so it never reads as a step
+	static constexpr uint8_t at_target = 4, no_step = 5;
+
+	uint8_t direction(const point_t p) const {
+		const auto i = size_t(p.y) * width + p.x;
+		return (directions[i / 2] >> (i % 2 * 4)) & 0xF;
+	}
+
+	bool wide() const { return !distances32.empty(); }
+
+	unsigned distance(const point_t p) const { //UINT_MAX for walls and cells no target can reach
+		const auto i = size_t(p.y) * width + p.x;
+		if (wide()) return distances32[i];
+		return distances16[i] == UINT16_MAX ? UINT_MAX : distances16[i];
+	}
+
+	point_t next_step(const point_t p) const { //p itself on a target or where there is no step
+		const auto direction = this->direction(p);
+		if (direction >= at_target) return p;
+		const point_t steps[] = { { 1, 0 }, { 0, 1 }, { -1, 0 }, { 0, -1 } };
+		return { p.x + steps[direction].x, p.y + steps[direction].y };
+	}
+
+	//header: "MZDF", version 2, width, height, bytes per distance (all u32), then the distances (max value = unreachable)
+	//and the packed directions, all little-endian
+	bool save(const char* file_name) const {
+		std::ofstream file(file_name, std::ios::binary);
+		if (!file) return false;
+		const uint32_t header[] = { 0x46445a4d, 2, width, height, wide() ? 4u : 2u };
+		file.write((const char*)header, sizeof(header));
+		if (wide()) file.write((const char*)distances32.data(), distances32.size() * sizeof(uint32_t));
+		else file.write((const char*)distances16.data(), distances16.size() * sizeof(uint16_t));
+		file.write((const char*)directions.data(), directions.size());
+		return bool(file);
+	}
+};
+
+//bfs run to exhaustion from every target at once; the grid is undirected, so distance from the targets is distance to them
+struct distance_field {
+	distance_field_t solve(const maze_t& maze, const std::vector<point_t>& targets) {
+		distance_field_t out;
+		out.width = maze.width;
+		out.height = maze.height;
+		out.directions.assign((size_t(maze.width) * maze.height + 1) / 2, uint8_t(distance_field_t::no_step * 0x11));
+
+		//no path can be longer than the number of open cells, so that bounds the width needed
+		if (maze.grid.count() < UINT16_MAX)
+			flood(maze, targets, out, out.distances16);
+		else
+			flood(maze, targets, out, out.distances32);
+		return out;
+	}
+
+private:
+	template <typename T>
+	void flood(const maze_t& maze, const std::vector<point_t>& targets, distance_field_t& out, std::vector<T>& distances) {
+		const size_t width = maze.width, cells = size_t(maze.width) * maze.height;
+		constexpr auto unreached = std::numeric_limits<T>::max();
+		distances.assign(cells, unreached);
+
+		auto set_direction = [&out](const size_t i, const uint8_t direction) {
+			auto& pair = out.directions[i / 2];
+			const auto shift = i % 2 * 4;
+			pair = uint8_t((pair & ~(0xF << shift)) | direction << shift);
+		};
+
+		std::vector<uint32_t> queue;
+		queue.reserve(cells);
+		for (const auto& target : targets) {
+			if (target.x < 0 || target.y < 0 || target.x >= int(maze.width) || target.y >= int(maze.height)) continue;
+			const auto i = size_t(target.y) * width + target.x;
+			if (!maze.grid[target] || distances[i] == 0) continue;
+			distances[i] = 0;
+			set_direction(i, distance_field_t::at_target);
+			queue.push_back(uint32_t(i));
+		}
+
+		for (size_t head = 0; head < queue.size(); ++head) {
+			const size_t current = queue[head];
+			const auto x = current % width, y = current / width;
+			auto visit = [&](const size_t v, const size_t vx, const size_t vy, const uint8_t back) {
+				if (!maze.grid.at(vx, vy) || distances[v] != unreached) return;
+				distances[v] = distances[current] + 1;
+				set_direction(v, back);
+				queue.push_back(uint32_t(v));
+			};
+			if (x + 1 < width) visit(current + 1, x + 1, y, 2);
+			if (y + 1 < maze.height) visit(current + width, x, y + 1, 3);
+			if (x >= 1) visit(current - 1, x - 1, y, 0);
+			if (y >= 1) visit(current - width, x, y - 1, 1);
+		}
+	}
+};
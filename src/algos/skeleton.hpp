@@ -0,0 +1,237 @@
+#pragma once
+#include "../includes.hpp"
+#include "../thinning.hpp"
+
+#include <unordered_map>
+
+//searches the medial axis instead of the pixels. the open cells are thinned to a skeleton, whose junctions and dead
+//ends become the nodes of a graph with one edge per corridor between them, so a wide corridor costs one edge instead
+//of thousands of cells. start and end snap to the nearest skeleton pixel, and the path follows the middle of every
+//corridor. diagonal skeleton steps only count when a side cell is open, and are drawn through it, so the path stays
+//4-connected like every other solver's
+struct skeleton : solution_interface {
+	bit_grid_t lines; //the skeleton of the last grid solved
+	size_t nodes = 0, edges = 0;
+
+	ret_t solve(const maze_t& maze) {
+		if (maze.grid.width != m_source.width || maze.grid.height != m_source.height || maze.grid.words != m_source.words) {
+			m_source = maze.grid;
+			lines = skeletonize(maze.grid);
+		}
+		const auto width = maze.width;
+		auto idx = [width](const point_t& p) { return size_t(p.y) * width + p.x; };
+
+		//sources and goals snap to the skeleton; where several land on one pixel the closest wins
+		std::unordered_map<size_t, std::vector<point_t>> source_snaps, goal_snaps;
+		auto snap_all = [&](const std::vector<point_t>& points, std::unordered_map<size_t, std::vector<point_t>>& out) {
+			for (const auto& p : points) {
+				auto path = snap(maze, p);
+				if (path.empty()) continue;
+				auto& best = out[idx(path.back())];
+				if (best.empty() || path.size() < best.size()) best = std::move(path);
+			}
+		};
+		snap_all(maze.sources(), source_snaps);
+		snap_all(maze.goals(), goal_snaps);
+		if (source_snaps.empty() || goal_snaps.empty()) return { false };
+
+		//nodes: every skeleton pixel without exactly two neighbours, plus the snapped endpoints
+		bit_grid_t is_node(maze.width, maze.height);
+		parallel_for(maze.height, [&](const size_t first_row, const size_t last_row) {
+			for (auto y = first_row; y < last_row; ++y)
+				for (size_t word = 0; word < lines.stride; ++word)
+					for (auto left = lines.row(y)[word]; left; left &= left - 1) {
+						const point_t p = { int(word * 64 + ctz64(left)), int(y) };
+						int degree = 0;
+						for (int direction = 0; direction < 8; ++direction) degree += linked(maze, p, direction);
+						if (degree != 2) is_node.set(p, true);
+					}
+		});
+		for (const auto& snaps : { &source_snaps, &goal_snaps })
+			for (const auto& snapped : *snaps) is_node.set(snapped.second.back(), true);
+
+		//found in reading order, so the cell indices come out sorted and a node is found by binary search
+		std::vector<point_t> positions;
+		std::vector<size_t> cells;
+		for (unsigned y = 0; y < maze.height; ++y)
+			for (size_t word = 0; word < is_node.stride; ++word)
+				for (auto left = is_node.row(y)[word]; left; left &= left - 1) {
+					positions.push_back({ int(word * 64 + ctz64(left)), int(y) });
+					cells.push_back(idx(positions.back()));
+				}
+		nodes = positions.size();
+		auto node_of = [&](const size_t cell) { return uint32_t(std::lower_bound(cells.begin(), cells.end(), cell) - cells.begin()); };
+
+		//edges: walk out of every node along each neighbour until the next node
+		std::vector<std::vector<edge_t>> graph(nodes);
+		parallel_for(nodes, [&](const size_t first, const size_t last) {
+			for (auto node = first; node < last; ++node)
+				for (int direction = 0; direction < 8; ++direction) {
+					if (!linked(maze, positions[node], direction)) continue;
+					unsigned length = 0;
+					const auto end = walk(maze, is_node, positions[node], direction, [&](const point_t&, const unsigned step) { length += step; });
+					graph[node].push_back({ node_of(idx(end)), length, uint8_t(direction) });
+				}
+		});
+		edges = 0;
+		for (const auto& out : graph) edges += out.size();
+
+		//dijkstra over the nodes, seeded with how far each source is from its snapped pixel
+		struct entry_t {
+			uint32_t node;
+			unsigned distance;
+			bool operator>(const entry_t& other) const { return distance > other.distance; }
+		};
+		std::priority_queue<entry_t, std::vector<entry_t>, std::greater<entry_t>> queue;
+		std::vector<unsigned> distances(nodes, UINT_MAX), goal_extra(nodes, UINT_MAX);
+		std::vector<std::pair<uint32_t, uint8_t>> previous(nodes, { UINT32_MAX, 0 }); //node and direction the best edge came from
+		for (const auto& snapped : source_snaps) {
+			const auto node = node_of(snapped.first);
+			distances[node] = unsigned(snapped.second.size() - 1);
+			queue.push({ node, distances[node] });
+		}
+		for (const auto& snapped : goal_snaps) goal_extra[node_of(snapped.first)] = unsigned(snapped.second.size() - 1);
+
+		auto best = UINT_MAX;
+		auto reached = UINT32_MAX;
+		while (!queue.empty()) {
+			const auto current = queue.top();
+			queue.pop();
+			if (current.distance > distances[current.node]) continue;
+			if (current.distance >= best) break; //no goal reached later can be closer
+			if (goal_extra[current.node] != UINT_MAX && current.distance + goal_extra[current.node] < best) {
+				best = current.distance + goal_extra[current.node];
+				reached = current.node;
+			}
+			for (const auto& edge : graph[current.node]) {
+				const auto distance = current.distance + edge.length;
+				if (distance < distances[edge.to]) {
+					distances[edge.to] = distance;
+					previous[edge.to] = { current.node, edge.direction };
+					queue.push({ edge.to, distance });
+				}
+			}
+		}
+
+		//the cost map holds the distance along the skeleton; off it everything is unreached
+		ret_t out = { reached != UINT32_MAX };
+		out.cost_map.assign(size_t(maze.width) * maze.height, UINT_MAX);
+		for (size_t node = 0; node < nodes; ++node) {
+			if (distances[node] == UINT_MAX) continue;
+			out.cost_map[idx(positions[node])] = std::min(out.cost_map[idx(positions[node])], distances[node]);
+			for (const auto& edge : graph[node]) {
+				auto distance = distances[node];
+				walk(maze, is_node, positions[node], edge.direction, [&](const point_t& p, const unsigned step) {
+					distance += step;
+					out.cost_map[idx(p)] = std::min(out.cost_map[idx(p)], distance);
+				});
+			}
+		}
+		if (!out.solved) return out;
+
+		std::vector<std::pair<uint32_t, uint8_t>> chain;
+		auto source = reached;
+		for (; previous[source].first != UINT32_MAX; source = previous[source].first) chain.push_back(previous[source]);
+		std::reverse(chain.begin(), chain.end());
+
+		out.path = source_snaps.at(idx(positions[source])); //snaps run from the endpoint to the skeleton
+		for (const auto& step : chain)
+			walk(maze, is_node, positions[step.first], step.second, [&](const point_t& p, unsigned) { append(maze, out.path, p); });
+		const auto& goal_snap = goal_snaps.at(idx(positions[reached]));
+		out.path.insert(out.path.end(), goal_snap.rbegin() + 1, goal_snap.rend());
+
+		//a snap can run back over pixels the skeleton path uses; cut out any loop that makes
+		std::unordered_map<size_t, size_t> position_in_path;
+		size_t kept = 0;
+		for (const auto& p : out.path) {
+			const auto found = position_in_path.find(idx(p));
+			if (found != position_in_path.end()) {
+				for (auto i = found->second + 1; i < kept; ++i) position_in_path.erase(idx(out.path[i]));
+				kept = found->second + 1;
+				continue;
+			}
+			position_in_path[idx(p)] = kept;
+			out.path[kept++] = p;
+		}
+		out.path.resize(kept);
+		out.from = out.path.front();
+		out.to = out.path.back();
+		return out;
+	}
+
+private:
+	struct edge_t {
+		uint32_t to;
+		unsigned length; //in 4-connected steps, so a diagonal counts 2
+		uint8_t direction; //of the first step out of the node
+	};
+
+	bit_grid_t m_source; //the grid lines was thinned from
+
+	//clockwise from north, the order the thinning tables use
+	static point_t offset(const int direction) {
+		const point_t offsets[] = { { 0, -1 }, { 1, -1 }, { 1, 0 }, { 1, 1 }, { 0, 1 }, { -1, 1 }, { -1, 0 }, { -1, -1 } };
+		return offsets[direction];
+	}
+
+	//skeleton pixels are joined diagonally only when neither side cell is on the skeleton (which would make the
+	//orthogonal pair the real link) and at least one side cell is open (or the step would cut through a wall corner)
+	bool linked(const maze_t& maze, const point_t p, const int direction) const {
+		const auto d = offset(direction);
+		const point_t q = { p.x + d.x, p.y + d.y };
+		if (q.x < 0 || q.y < 0 || q.x >= int(maze.width) || q.y >= int(maze.height) || !lines[q]) return false;
+		if (direction % 2 == 0) return true;
+		const point_t a = { q.x, p.y }, b = { p.x, q.y };
+		return !lines[a] && !lines[b] && (maze.grid[a] || maze.grid[b]);
+	}
+
+	//follows the corridor leaving from in the given direction, calling visit(pixel, step length) for every pixel up
+	//to and including the next node, which it returns
+	template <typename F>
+	point_t walk(const maze_t& maze, const bit_grid_t& is_node, const point_t from, int direction, F&& visit) const {
+		auto previous = from;
+		auto at = point_t{ from.x + offset(direction).x, from.y + offset(direction).y };
+		visit(at, direction % 2 ? 2u : 1u);
+		while (!is_node[at]) {
+			for (direction = 0; direction < 8; ++direction) {
+				const point_t next = { at.x + offset(direction).x, at.y + offset(direction).y };
+				if (!(next == previous) && linked(maze, at, direction)) break;
+			}
+			previous = at;
+			at = { at.x + offset(direction).x, at.y + offset(direction).y };
+			visit(at, direction % 2 ? 2u : 1u);
+		}
+		return at;
+	}
+
+	//adds p to the path, through an open side cell when the step is diagonal
+	static void append(const maze_t& maze, std::vector<point_t>& path, const point_t p) {
+		const auto last = path.back();
+		if (last.x != p.x && last.y != p.y) path.push_back(maze.grid[point_t{ p.x, last.y }] ? point_t{ p.x, last.y } : point_t{ last.x, p.y });
+		path.push_back(p);
+	}
+
+	//the shortest 4-connected route through open cells from p to the nearest skeleton pixel, p first. empty when p is
+	//a wall. skeletonize leaves some skeleton in every component, so this ends at the nearest one, not after
+	//flooding the whole component
+	std::vector<point_t> snap(const maze_t& maze, const point_t p) const {
+		if (!maze.grid[p]) return {};
+		auto idx = [&maze](const point_t& q) { return size_t(q.y) * maze.width + q.x; };
+		std::unordered_map<size_t, point_t> previous = { { idx(p), p } };
+		std::queue<point_t> queue;
+		queue.push(p);
+		while (!queue.empty()) {
+			auto current = queue.front();
+			queue.pop();
+			if (lines[current]) {
+				std::vector<point_t> out = { current };
+				while (!(current == p)) out.push_back(current = previous[idx(current)]);
+				std::reverse(out.begin(), out.end());
+				return out;
+			}
+			for (const auto& v : current.neighbours(maze.width, maze.height))
+				if (maze.grid[v] && previous.emplace(idx(v), current).second) queue.push(v);
+		}
+		return {};
+	}
+};
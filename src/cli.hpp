@@ -0,0 +1,367 @@
+#pragma once
+#include "includes.hpp"
+#include "image_manip.hpp"
+#include "image_loader.hpp"
+#include "components.hpp"
+#include "lattice.hpp"
+#include "endpoints.hpp"
+#include "roi.hpp"
+#include "rectify.hpp"
+
+#include "algos/dijkstra.hpp"
+#include "algos/a_star.hpp"
+#include "algos/breadth_first.hpp"
+#include "algos/depth_first.hpp"
+#include "algos/skeleton.hpp"
+#include "algos/batch_breadth_first.hpp"
+#include "algos/distance_field.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+//headless solving for mazes too big to look at: maze solver <image> [options]
+struct cli_options_t {
+	std::string input, output, save_maze, queries, flow_field, algo = "breadth_first";
+	bool has_start = false, has_end = false, has_binarization = false, border_exit = false, grid_only = false, lattice = false, crop = false, rectify = false, has_corners = false;
+	point_t start = { 0, 0 }, end = { 0, 0 };
+	int threshold = 200, radius = 0;
+	binarize_method_t binarize = binarize_method_t::global;
+	cleanup_t cleanup;
+	roi_t roi;
+	corners_t corners = {};
+	unsigned rectify_size = 2048;
+};
+
+inline void print_cli_usage() {
+	printf("usage: maze solver <image> [options]\n"
+		"  images: png, jpg, bmp, tga, gif, pbm (P4), pgm (P5), maze\n"
+		"  --algo <name>      dijkstra, a_star, breadth_first (default), depth_first or skeleton\n"
+		"  --start <x,y>      default the one saved in a .maze file, else a gap in the outer wall, else 0,0\n"
+		"  --end <x,y>        default the one saved in a .maze file, else another gap, else the bottom right corner\n"
+		"  --threshold <n>    luminance above which a pixel is open, default 200 (ignored for pbm)\n"
+		"  --binarize <name>  global (default), otsu, bradley or sauvola; the last two adapt to uneven lighting\n"
+		"  --radius <n>       window radius for bradley and sauvola, default a sixteenth of the shorter side\n"
+		"  --cleanup <op>     open, close or open+close the open cells to remove jpeg pinholes and specks\n"
+		"  --element <name>   square (default), cross or diamond, the shape --cleanup works with\n"
+		"  --cleanup-radius <n>  default 1, keep it below half the wall width\n"
+		"                     a .maze file comes back binarized and cleaned as saved unless one of the six above is given\n"
+		"  --border-exit      solve to the nearest opening in the outer wall instead of --end\n"
+		"  --lattice          solve one cell per corridor when the maze is drawn on a regular grid\n"
+		"  --crop             solve only inside the box around the maze's walls, leaving out the margin\n"
+		"  --roi <x,y,w,h>    solve only inside this rectangle\n"
+		"  --rectify          straighten a photographed maze between its corners, found from its walls, and solve that\n"
+		"  --corners <x,y,x,y,x,y,x,y>  the maze's corners in the photo for --rectify, in any order\n"
+		"  --rectify-size <n> longer side of the straightened maze, default 2048; --start and --end stay in photo pixels\n"
+		"  --out <file>       write the solved maze, jpg if the name ends in .jpg, otherwise png\n"
+		"  --save-maze <file> convert the image to a .maze file that later loads without decoding, then exit\n"
+		"  --grid-only        leave the luminance out of --save-maze, it can then only be solved at one threshold\n"
+		"  --queries <file>   print the shortest distance for every \"sx,sy ex,ey\" line of the file, 64 starts per sweep, then exit\n"
+		"  --flow-field <file>  write every open cell's distance and step towards --end (or the border exits), then exit\n");
+}
+
+inline bool parse_cli_point(const char* text, point_t& out) {
+	return sscanf(text, "%d,%d", &out.x, &out.y) == 2;
+}
+
+inline int cli_name_index(const std::string& name, const char* const* names, const int count) {
+	for (int i = 0; i < count; ++i)
+		if (name == names[i]) return i;
+	return -1;
+}
+
+inline bool parse_cli_options(const int argc, char** argv, cli_options_t& options) {
+	for (int i = 1; i < argc; ++i) {
+		const std::string arg = argv[i];
+		const auto value = i + 1 < argc ? argv[i + 1] : nullptr;
+		if (arg == "--border-exit") options.border_exit = true;
+		else if (arg == "--grid-only") options.grid_only = true;
+		else if (arg == "--lattice") options.lattice = true;
+		else if (arg == "--crop") options.crop = true;
+		else if (arg == "--rectify") options.rectify = true;
+		else if (arg.rfind("--", 0) != 0) options.input = arg;
+		else if (!value) return false;
+		else if (arg == "--algo") options.algo = argv[++i];
+		else if (arg == "--start") options.has_start = parse_cli_point(argv[++i], options.start);
+		else if (arg == "--end") options.has_end = parse_cli_point(argv[++i], options.end);
+		else if (arg == "--roi") {
+			auto& roi = options.roi;
+			if (sscanf(argv[++i], "%u,%u,%u,%u", &roi.x, &roi.y, &roi.width, &roi.height) != 4 || roi.empty()) return false;
+		}
+		else if (arg == "--corners") {
+			auto& c = options.corners;
+			if (sscanf(argv[++i], "%lf,%lf,%lf,%lf,%lf,%lf,%lf,%lf", &c[0].x, &c[0].y, &c[1].x, &c[1].y, &c[2].x, &c[2].y, &c[3].x, &c[3].y) != 8) return false;
+			c = order_corners(c);
+			options.rectify = options.has_corners = true;
+		}
+		else if (arg == "--rectify-size") options.rectify_size = unsigned(std::max(16, atoi(argv[++i])));
+		else if (arg == "--threshold") options.threshold = atoi(argv[++i]), options.has_binarization = true;
+		else if (arg == "--radius") options.radius = atoi(argv[++i]), options.has_binarization = true;
+		else if (arg == "--cleanup-radius") options.cleanup.radius = atoi(argv[++i]), options.has_binarization = true;
+		else if (arg == "--binarize") {
+			const auto method = cli_name_index(argv[++i], binarize_method_names, 4);
+			if (method < 0) return false;
+			options.binarize = binarize_method_t(method);
+			options.has_binarization = true;
+		}
+		else if (arg == "--cleanup") {
+			const auto op = cli_name_index(argv[++i], morph_op_names, 4);
+			if (op < 0) return false;
+			options.cleanup.op = morph_op_t(op);
+			options.has_binarization = true;
+		}
+		else if (arg == "--element") {
+			const auto element = cli_name_index(argv[++i], morph_element_names, 3);
+			if (element < 0) return false;
+			options.cleanup.element = morph_element_t(element);
+			options.has_binarization = true;
+		}
+		else if (arg == "--out") options.output = argv[++i];
+		else if (arg == "--save-maze") options.save_maze = argv[++i];
+		else if (arg == "--queries") options.queries = argv[++i];
+		else if (arg == "--flow-field") options.flow_field = argv[++i];
+		else return false;
+	}
+	return !options.input.empty();
+}
+
+inline bool write_cli_output(const std::string& file_name, const maze_t& maze, const ret_t& ret) {
+	std::vector<rgba_t> pixels(size_t(maze.width) * maze.height);
+	parallel_for(maze.height, [&](const size_t first_row, const size_t last_row) {
+		for (auto y = first_row; y < last_row; ++y)
+			for (size_t x = 0; x < maze.width; ++x)
+				pixels[y * maze.width + x] = maze.grid.at(x, y) ? gray : black;
+	});
+	for (size_t i = 0; i < ret.path.size(); ++i) {
+		const auto r = uint8_t((float)i / (float)ret.path.size() * 255.f);
+		pixels[size_t(ret.path[i].y) * maze.width + ret.path[i].x] = { r, 0, uint8_t(0xFF - r), 0xFF };
+	}
+	const auto jpg = file_name.size() >= 4 && file_name.compare(file_name.size() - 4, 4, ".jpg") == 0;
+	if (jpg) return stbi_write_jpg(file_name.c_str(), maze.width, maze.height, 4, pixels.data(), 100) != 0;
+	return stbi_write_png(file_name.c_str(), maze.width, maze.height, 4, pixels.data(), maze.width * 4) != 0;
+}
+
+//answers every query in file on maze with one batch_breadth_first. to_maze maps the points given into the maze, and
+//the distances printed are between the points after moving them off walls
+template <typename F>
+int run_cli_queries(const std::string& file_name, const maze_t& maze, F&& to_maze) {
+	const auto file = fopen(file_name.c_str(), "r");
+	if (!file) {
+		fprintf(stderr, "could not read %s\n", file_name.c_str());
+		return 1;
+	}
+	std::vector<query_t> queries;
+	char line[256];
+	for (int number = 1; fgets(line, sizeof(line), file); ++number) {
+		query_t query;
+		if (sscanf(line, "%d,%d %d,%d", &query.start.x, &query.start.y, &query.end.x, &query.end.y) != 4) {
+			if (line[strspn(line, " \t\r\n")] == '\0') continue; //blank
+			fprintf(stderr, "%s:%d: expected \"sx,sy ex,ey\"\n", file_name.c_str(), number);
+			fclose(file);
+			return 2;
+		}
+		query = { to_maze(query.start), to_maze(query.end) };
+		snap_to_open(maze.grid, query.start); //like --start and --end, a point on a wall moves to the nearest corridor
+		snap_to_open(maze.grid, query.end);
+		queries.push_back(query);
+	}
+	fclose(file);
+
+	const auto timer = std::chrono::steady_clock::now();
+	const auto results = batch_breadth_first{}.solve(maze, queries);
+	printf("%zu queries in %.1f ms\n", queries.size(), std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - timer).count());
+	auto solved = size_t(0);
+	for (size_t i = 0; i < queries.size(); ++i) {
+		const auto& q = queries[i];
+		if (results[i].solved) printf("%d,%d %d,%d: %u\n", q.start.x, q.start.y, q.end.x, q.end.y, results[i].distance);
+		else printf("%d,%d %d,%d: no path\n", q.start.x, q.start.y, q.end.x, q.end.y);
+		solved += results[i].solved;
+	}
+	return solved == queries.size() ? 0 : 1;
+}
+
+inline int run_cli(const int argc, char** argv) {
+	cli_options_t options;
+	if (!parse_cli_options(argc, argv, options)) {
+		print_cli_usage();
+		return 2;
+	}
+
+	dijkstra dijkstra_algo;
+	a_star a_star_algo;
+	breadth_first breadth_first_algo;
+	depth_first depth_first_algo;
+	skeleton skeleton_algo;
+	solution_interface* algo = nullptr;
+	if (options.algo == "dijkstra") algo = &dijkstra_algo;
+	else if (options.algo == "a_star") algo = &a_star_algo;
+	else if (options.algo == "breadth_first") algo = &breadth_first_algo;
+	else if (options.algo == "depth_first") algo = &depth_first_algo;
+	else if (options.algo == "skeleton") algo = &skeleton_algo;
+	else {
+		fprintf(stderr, "unknown algorithm: %s\n", options.algo.c_str());
+		return 2;
+	}
+	lattice_solver lattice;
+	if (options.lattice) {
+		lattice.inner = algo;
+		algo = &lattice;
+	}
+
+	using clock = std::chrono::steady_clock;
+	const auto ms_since = [](const clock::time_point since) {
+		return std::chrono::duration<double, std::milli>(clock::now() - since).count();
+	};
+
+	binarization_t saved;
+	if (!options.has_binarization && load_saved_binarization(options.input.c_str(), saved)) {
+		options.threshold = saved.threshold;
+		options.binarize = saved.method;
+		options.radius = saved.radius;
+		options.cleanup = saved.cleanup;
+	}
+
+	auto timer = clock::now();
+	maze_t maze;
+	source_image_t source; //everything but a global threshold needs the whole luminance plane
+	const auto global = options.binarize == binarize_method_t::global && !options.rectify;
+	if (global ? !load_grid_from_file(options.input.c_str(), options.threshold, maze.grid, options.cleanup) : !source.load(options.input)) {
+		fprintf(stderr, "could not load %s\n", options.input.c_str());
+		return 1;
+	}
+	rectification_t rectification;
+	source_image_t rectified; //the straightened photo, binarized instead of it
+	if (options.rectify) {
+		printf("loaded %ux%u in %.1f ms\n", source.luminance.width, source.luminance.height, ms_since(timer));
+		timer = clock::now();
+		auto& corners = options.corners;
+		if (!options.has_corners && !find_corners(source.luminance, corners)) {
+			fprintf(stderr, "no maze walls found to rectify\n");
+			return 1;
+		}
+		if (!rectify_photo(source.luminance, corners, options.rectify_size, rectification, rectified)) {
+			fprintf(stderr, "the corners don't make a quad\n");
+			return 2;
+		}
+		printf("rectified %.0f,%.0f %.0f,%.0f %.0f,%.0f %.0f,%.0f to %ux%u in %.1f ms\n", corners[0].x, corners[0].y, corners[1].x, corners[1].y,
+			corners[2].x, corners[2].y, corners[3].x, corners[3].y, rectification.width, rectification.height, ms_since(timer));
+		timer = clock::now();
+	}
+	auto& binarized = options.rectify ? rectified : source;
+	if (!global) {
+		maze.grid = binarized.grid(options.threshold, options.binarize, options.radius, options.cleanup); //a saved grid at its own settings comes back as is
+		if (options.binarize == binarize_method_t::otsu) options.threshold = otsu_threshold(binarized.histogram);
+	}
+	maze.width = maze.grid.width;
+	maze.height = maze.grid.height;
+	printf(options.rectify ? "binarized %ux%u in %.1f ms\n" : "loaded %ux%u in %.1f ms\n", maze.width, maze.height, ms_since(timer));
+	//--start, --end and saved endpoints are photo pixels, found ones are already on the maze
+	const auto from_photo = [&](const point_t p) { return options.rectify ? rectification.rectified_point(p) : p; };
+	point_t found_start = { 0, 0 }, found_end = { int(maze.width) - 1, int(maze.height) - 1 };
+	if (load_saved_endpoints(options.input.c_str(), found_start, found_end)) {
+		found_start = from_photo(found_start);
+		found_end = from_photo(found_end);
+	}
+	else if (!options.has_start || !options.has_end) {
+		timer = clock::now();
+		const auto found = propose_endpoints(maze.grid, found_start, found_end);
+		if (found) printf("found %d entrance%s in %.1f ms\n", found, found == 1 ? "" : "s", ms_since(timer));
+	}
+	maze.start = options.has_start ? from_photo(options.start) : found_start;
+	maze.end = options.has_end ? from_photo(options.end) : found_end;
+
+	if (!options.save_maze.empty()) {
+		timer = clock::now();
+		auto& luminance = binarized.luminance;
+		if (options.grid_only) luminance = {};
+		else if (global && !load_luminance_from_file(options.input.c_str(), luminance)) luminance = {};
+		const binarization_t binarization = { options.threshold, options.binarize, options.radius, options.cleanup };
+		if (!maze_file_t::save(options.save_maze.c_str(), maze, binarization, luminance.pixels)) {
+			fprintf(stderr, "could not write %s\n", options.save_maze.c_str());
+			return 1;
+		}
+		printf("saved %s in %.1f ms\n", options.save_maze.c_str(), ms_since(timer));
+		return 0;
+	}
+
+	if (!options.queries.empty()) return run_cli_queries(options.queries, maze, from_photo);
+
+	const auto inside = [&](const point_t p) { return p.x >= 0 && p.y >= 0 && p.x < int(maze.width) && p.y < int(maze.height); };
+	if (!inside(maze.start) || !inside(maze.end)) {
+		fprintf(stderr, "start and end must lie inside the image\n");
+		return 2;
+	}
+	for (auto point : { &maze.start, &maze.end }) {
+		const auto given = *point;
+		if (!snap_to_open(maze.grid, *point)) break; //no open cells at all, the solve reports it
+		if (!(*point == given)) printf("%d,%d is a wall, moved to %d,%d\n", given.x, given.y, point->x, point->y);
+	}
+
+	if (!options.flow_field.empty()) { //over the whole maze, like the gui's export
+		timer = clock::now();
+		if (options.border_exit) maze.ends = open_border_cells(maze);
+		if (options.border_exit && maze.ends.empty()) {
+			fprintf(stderr, "no border exits\n");
+			return 1;
+		}
+		const auto field = distance_field{}.solve(maze, maze.goals());
+		if (!field.save(options.flow_field.c_str())) {
+			fprintf(stderr, "could not write %s\n", options.flow_field.c_str());
+			return 1;
+		}
+		printf("wrote the flow field to %s in %.1f ms\n", options.flow_field.c_str(), ms_since(timer));
+		return 0;
+	}
+
+	auto roi = options.roi.clipped(maze.width, maze.height);
+	if (!options.roi.empty() && roi.empty()) {
+		fprintf(stderr, "the roi lies outside the image\n");
+		return 2;
+	}
+	if (options.crop && roi.empty()) {
+		timer = clock::now();
+		roi = maze_bounds(maze.grid);
+		printf("maze bounds: %ux%u at %u,%u in %.1f ms\n", roi.width, roi.height, roi.x, roi.y, ms_since(timer));
+	}
+	maze_t cropped;
+	auto& solving = roi.empty() ? maze : (cropped = crop_maze(maze, roi)); //the full maze is kept for the output image
+	if (options.border_exit) {
+		solving.ends = open_border_cells(solving);
+		if (solving.ends.empty()) { //not the end point instead, which goals() would fall back to
+			fprintf(stderr, "no border exits\n");
+			return 1;
+		}
+	}
+
+	timer = clock::now();
+	components_t components;
+	if (!components.build(solving)) {
+		fprintf(stderr, "maze too large: more than %llu cells\n", (unsigned long long)components_t::max_cells);
+		return 1;
+	}
+	printf("components: %zu, loops: %lld\n", components.count, (long long)components.count - euler_number(solving.grid));
+	const auto reachable = components.restrict_to_reachable(solving);
+	auto ret = reachable ? algo->solve(solving) : ret_t{ false };
+	if (!roi.empty()) uncrop_result(ret, roi, maze.width, maze.height, false);
+	printf("solved: %s in %.1f ms\n", ret.solved ? "yes" : "no", ms_since(timer));
+	if (algo == &skeleton_algo && reachable) printf("skeleton: %zu pixels, %zu nodes, %zu edges\n", skeleton_algo.lines.count(), skeleton_algo.nodes, skeleton_algo.edges / 2);
+	if (options.lattice && reachable) {
+		const auto& found = lattice.lattice;
+		if (lattice.used_lattice) printf("lattice: pitch %u x %u, wall %u, corridor %u, %ux%u cells\n", found.x.pitch, found.y.pitch, found.x.wall, found.x.corridor, found.grid.width, found.grid.height);
+		else printf("lattice: no regular pitch, solved per pixel\n");
+	}
+	if (!ret.solved) return 1;
+	printf("path: %zu cells from %d,%d to %d,%d\n", ret.path.size(), ret.from.x, ret.from.y, ret.to.x, ret.to.y);
+
+	if (options.rectify && !options.output.empty()) { //the output is the photo, with the path mapped back onto it
+		ret.path = path_to_photo(ret.path, rectification, source.luminance.width, source.luminance.height);
+		maze = { source.luminance.width, source.luminance.height, rectification.photo_point(ret.from), rectification.photo_point(ret.to) };
+		maze.grid = source.grid(options.threshold, options.binarize, options.radius, options.cleanup);
+		printf("path on the photo: %zu pixels from %d,%d to %d,%d\n", ret.path.size(), maze.start.x, maze.start.y, maze.end.x, maze.end.y);
+	}
+	if (!options.output.empty() && !write_cli_output(options.output, maze, ret)) {
+		fprintf(stderr, "could not write %s\n", options.output.c_str());
+		return 1;
+	}
+	return 0;
+}
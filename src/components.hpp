@@ -0,0 +1,135 @@
+#pragma once
+#include "includes.hpp"
+
+//connected regions of open cells, labelled with a union-find built in parallel over row bands. two cells in
+//different components can never be joined by a path, so such queries are rejected without searching. labels are 32-bit
+//cell indices, so a grid of more than max_cells cells is refused instead of silently wrapping
+struct components_t {
+	static constexpr uint32_t wall = UINT32_MAX;
+	static constexpr uint64_t max_cells = UINT32_MAX;
+
+	unsigned width = 0, height = 0;
+	std::vector<uint32_t> labels; //index of the component's root cell, wall for walls
+	size_t count = 0;
+
+	//false, with nothing labelled, when the grid has more than max_cells cells
+	bool build(const maze_t& maze) {
+		width = height = 0;
+		labels.clear();
+		count = 0;
+		if (uint64_t(maze.width) * maze.height > max_cells) return false;
+		width = maze.width;
+		height = maze.height;
+		const size_t cells = size_t(width) * height;
+		std::vector<uint32_t> parent(cells);
+
+		auto find = [&parent](uint32_t i) {
+			while (parent[i] != i) {
+				parent[i] = parent[parent[i]]; //path halving
+				i = parent[i];
+			}
+			return i;
+		};
+		auto unite = [&](const uint32_t a, const uint32_t b) {
+			const auto root_a = find(a), root_b = find(b);
+			if (root_a < root_b) parent[root_b] = root_a;
+			else parent[root_a] = root_b;
+		};
+
+		//each band only links cells inside itself, so bands never touch each other's part of the forest
+		std::vector<size_t> band_starts;
+		std::mutex band_mutex;
+		parallel_for(height, [&](const size_t first_row, const size_t last_row) {
+			if (first_row == last_row) return;
+			{
+				std::lock_guard<std::mutex> lock(band_mutex);
+				band_starts.push_back(first_row);
+			}
+			for (auto y = first_row; y < last_row; ++y) {
+				for (size_t x = 0; x < width; ++x) {
+					const auto i = uint32_t(y * width + x);
+					parent[i] = i;
+					if (!maze.grid.at(x, y)) continue;
+					if (x > 0 && maze.grid.at(x - 1, y)) unite(i, i - 1);
+					if (y > first_row && maze.grid.at(x, y - 1)) unite(i, i - width);
+				}
+			}
+		});
+
+		for (const auto first_row : band_starts) { //stitch the bands together along their top rows
+			if (first_row == 0) continue;
+			for (size_t x = 0; x < width; ++x) {
+				const auto i = uint32_t(first_row * width + x);
+				if (maze.grid.at(x, first_row) && maze.grid.at(x, first_row - 1)) unite(i, i - width);
+			}
+		}
+
+		labels.resize(cells);
+		std::vector<size_t> band_counts(height);
+		parallel_for(height, [&](const size_t first_row, const size_t last_row) {
+			for (auto y = first_row; y < last_row; ++y) {
+				for (size_t x = 0; x < width; ++x) {
+					const auto i = y * width + x;
+					if (!maze.grid.at(x, y)) {
+						labels[i] = wall;
+						continue;
+					}
+					auto root = uint32_t(i); //read-only walk, other bands are reading the same forest
+					while (parent[root] != root) root = parent[root];
+					labels[i] = root;
+					band_counts[y] += root == i;
+				}
+			}
+		});
+		count = std::accumulate(band_counts.begin(), band_counts.end(), size_t(0));
+		return true;
+	}
+
+	uint32_t label(const point_t p) const { return labels[size_t(p.y) * width + p.x]; }
+
+	bool connected(const point_t a, const point_t b) const { return label(a) != wall && label(a) == label(b); }
+
+	//drops the sources and goals whose component holds no endpoint of the other kind, so a multi-source search only
+	//floods components that can produce an answer. returns false when no pair is left
+	bool restrict_to_reachable(maze_t& maze) const {
+		if (maze.starts.empty() && maze.ends.empty())
+			return connected(maze.start, maze.end);
+
+		auto sources = maze.sources(), goals = maze.goals();
+		std::vector<uint32_t> source_labels, goal_labels;
+		for (const auto& source : sources) source_labels.push_back(label(source));
+		for (const auto& goal : goals) goal_labels.push_back(label(goal));
+		std::sort(source_labels.begin(), source_labels.end());
+		std::sort(goal_labels.begin(), goal_labels.end());
+
+		auto keep = [this](std::vector<point_t>& points, const std::vector<uint32_t>& others) {
+			points.erase(std::remove_if(points.begin(), points.end(), [&](const point_t& p) {
+				return label(p) == wall || !std::binary_search(others.begin(), others.end(), label(p));
+			}), points.end());
+		};
+		keep(sources, goal_labels);
+		keep(goals, source_labels);
+		if (sources.empty() || goals.empty()) return false;
+
+		maze.starts = sources;
+		maze.ends = goals;
+		maze.start = sources.front();
+		maze.end = goals.front();
+		return true;
+	}
+
+	std::vector<rgba_t> colorize() const { //one arbitrary colour per component, walls black
+		std::vector<rgba_t> out(labels.size());
+		parallel_for(height, [&](const size_t first_row, const size_t last_row) {
+			for (auto i = first_row * width; i < last_row * width; ++i) {
+				if (labels[i] == wall) {
+					out[i] = { 0x00, 0x00, 0x00, 0xFF };
+					continue;
+				}
+				const auto hash = labels[i] * 2654435761u;
+				out[i] = { uint8_t(0x40 | hash >> 24), uint8_t(0x40 | hash >> 16), uint8_t(0x40 | hash >> 8), 0xFF };
+			}
+		});
+		return out;
+	}
+};
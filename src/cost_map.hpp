@@ -0,0 +1,92 @@
+#pragma once
+#include "includes.hpp"
+#include "image_kernels.hpp"
+#include "tiled_view.hpp"
+
+enum class cost_scale_t { linear, log };
+enum class colormap_t { gray, heat };
+
+//colormap_size colours from the lowest cost to the highest. heat runs blue to red like a path coloured by value
+inline std::vector<rgba_t> make_colormap(const colormap_t map) {
+	std::vector<rgba_t> lut(colormap_size);
+	for (int i = 0; i < colormap_size; ++i) {
+		const auto v = uint8_t(i * 255 / (colormap_size - 1));
+		lut[i] = map == colormap_t::heat ? rgba_t{ v, 0, uint8_t(0xFF - v), 0xFF } : rgba_t{ v, v, v, 0xFF };
+	}
+	return lut;
+}
+
+//a solve's cost map as colours over the image, in its own texture tiles rather than in the image's pixels, so the
+//scale or colours can change without solving again and the maze stays untouched under cells nothing reached
+struct cost_overlay_t {
+	cost_overlay_t() = default;
+	cost_overlay_t(const cost_overlay_t&) = delete;
+	cost_overlay_t& operator=(const cost_overlay_t&) = delete;
+
+	bool empty() const { return m_costs.empty(); }
+
+	void clear() {
+		m_view.set_image(nullptr, 0, 0);
+		m_costs = {};
+		m_pixels = {};
+	}
+
+	//keeps width x height costs, UINT_MAX where unreached, and renders them
+	void set(std::vector<unsigned> costs, const unsigned width, const unsigned height, const cost_scale_t scale, const colormap_t map) {
+		m_costs = std::move(costs);
+		m_width = width;
+		m_height = height;
+		m_max = 0;
+		std::vector<unsigned> row_max(height, 0);
+		parallel_for(height, [&](const size_t first_row, const size_t last_row) {
+			for (auto y = first_row; y < last_row; ++y) {
+				auto highest = 0u;
+				for (auto c = &m_costs[y * width], end = c + width; c != end; ++c) highest = std::max(highest, *c == UINT_MAX ? 0u : *c);
+				row_max[y] = highest;
+			}
+		});
+		if (height) m_max = *std::max_element(row_max.begin(), row_max.end());
+		render(scale, map);
+	}
+
+	//colours the costs again, the highest one at the top of the colormap
+	void render(const cost_scale_t scale, const colormap_t map) {
+		if (m_costs.empty()) return;
+		const auto log = scale == cost_scale_t::log;
+		const auto lut = make_colormap(map);
+		const auto top = colormap_key(m_max, log);
+		const auto by = top > 0 ? float(colormap_size) / top : 0.f; //the highest lands on the clamp, each entry gets an equal range
+		const auto& kernels = image_kernels();
+		m_view.cancel_uploads(); //they read the pixels about to change
+		m_pixels.resize(m_costs.size());
+		parallel_for(m_height, [&](const size_t first_row, const size_t last_row) {
+			for (auto y = first_row; y < last_row; ++y)
+				kernels.colormap(&m_costs[y * m_width], &m_pixels[y * m_width], m_width, lut.data(), by, log);
+		});
+		m_view.set_image(m_pixels.data(), m_width, m_height);
+	}
+
+	//draws it exactly over the image shown by under
+	void draw(ImDrawList* list, const ImVec2 origin, const ImVec2 size, const tiled_view_t& under) {
+		if (m_costs.empty()) return;
+		m_view.zoom = under.zoom;
+		m_view.x = under.x;
+		m_view.y = under.y;
+		m_view.draw(list, origin, size);
+	}
+
+	//writes the reached cells into a width x height image, for saving what is on screen
+	void burn(std::vector<rgba_t>& pixels) const {
+		if (m_pixels.size() != pixels.size()) return;
+		parallel_for(m_pixels.size(), [&](const size_t first, const size_t last) {
+			for (auto i = first; i < last; ++i)
+				if (m_pixels[i].a) pixels[i] = m_pixels[i];
+		});
+	}
+
+private:
+	std::vector<unsigned> m_costs;
+	std::vector<rgba_t> m_pixels;
+	unsigned m_width = 0, m_height = 0, m_max = 0;
+	tiled_view_t m_view;
+};
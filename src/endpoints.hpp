@@ -0,0 +1,227 @@
+#pragma once
+#include "includes.hpp"
+
+//finding where a maze starts and ends without the user placing the points
+
+//nearest open cell to every cell of the w x h window at (x0, y0), or { -1, -1 } when the window has none. this is
+//felzenszwalb and huttenlocher's separable euclidean distance transform, keeping the argmin instead of the distance:
+//first the nearest open column along each row, then for each column the lower envelope of the parabolas
+//(y - q)^2 + row distance(q)^2, both passes in parallel
+inline std::vector<point_t> nearest_open_cells(const bit_grid_t& grid, const unsigned x0, const unsigned y0, const unsigned w, const unsigned h) {
+	const auto none = INT_MAX;
+	std::vector<int> column(size_t(w) * h, none); //nearest open column in the same row
+	parallel_for(h, [&](const size_t first_row, const size_t last_row) {
+		for (auto y = first_row; y < last_row; ++y) {
+			const auto nearest = &column[y * w];
+			auto last_open = none;
+			for (unsigned x = 0; x < w; ++x) {
+				if (grid.at(x0 + x, unsigned(y0 + y))) last_open = int(x);
+				nearest[x] = last_open;
+			}
+			last_open = none;
+			for (auto x = int(w) - 1; x >= 0; --x) {
+				if (nearest[x] == x) last_open = x;
+				if (last_open != none && (nearest[x] == none || last_open - x < x - nearest[x])) nearest[x] = last_open;
+			}
+		}
+	});
+
+	std::vector<point_t> out(size_t(w) * h, { -1, -1 });
+	parallel_for(w, [&](const size_t first_column, const size_t last_column) {
+		std::vector<int> rows(h); //rows whose parabolas make up the envelope
+		std::vector<double> starts(h + 1); //where each one takes over
+		for (auto x = first_column; x < last_column; ++x) {
+			auto height = [&](const int y) { const auto dx = double(column[size_t(y) * w + x]) - double(x); return dx * dx; };
+			int count = 0;
+			for (int y = 0; y < int(h); ++y) {
+				if (column[size_t(y) * w + x] == none) continue;
+				const auto f = height(y);
+				auto meet = 0.;
+				while (count > 0) {
+					const auto q = rows[count - 1];
+					meet = ((f + double(y) * y) - (height(q) + double(q) * q)) / (2. * (y - q));
+					if (meet > starts[count - 1]) break;
+					--count;
+				}
+				rows[count] = y;
+				starts[count] = count == 0 ? -1e300 : meet;
+				++count;
+			}
+			if (count == 0) continue;
+			starts[count] = 1e300;
+			for (int y = 0, k = 0; y < int(h); ++y) {
+				while (starts[k + 1] < y) ++k;
+				out[size_t(y) * w + x] = { int(x0) + column[size_t(rows[k]) * w + x], int(y0) + rows[k] };
+			}
+		}
+	});
+	return out;
+}
+
+//moves p onto the nearest open cell. the transform runs on a window around p that grows until the nearest open
+//cell in it is closer than the window's edge, so a point just off a corridor costs a few thousand cells, not the
+//image. false when the grid has no open cell at all
+inline bool snap_to_open(const bit_grid_t& grid, point_t& p) {
+	if (grid.width == 0 || grid.height == 0) return false;
+	p.x = std::min(std::max(p.x, 0), int(grid.width) - 1);
+	p.y = std::min(std::max(p.y, 0), int(grid.height) - 1);
+	if (grid[p]) return true;
+	for (long long radius = 32;; radius *= 4) {
+		const auto x0 = unsigned(std::max(0ll, p.x - radius)), y0 = unsigned(std::max(0ll, p.y - radius));
+		const auto x1 = unsigned(std::min<long long>(grid.width, p.x + radius + 1)), y1 = unsigned(std::min<long long>(grid.height, p.y + radius + 1));
+		const auto whole = x0 == 0 && y0 == 0 && x1 == grid.width && y1 == grid.height;
+		const auto nearest = nearest_open_cells(grid, x0, y0, x1 - x0, y1 - y0)[size_t(p.y - y0) * (x1 - x0) + (p.x - x0)];
+		const auto dx = (long long)nearest.x - p.x, dy = (long long)nearest.y - p.y;
+		if (nearest.x >= 0 && (whole || dx * dx + dy * dy <= radius * radius)) {
+			p = nearest;
+			return true;
+		}
+		if (whole) return false;
+	}
+}
+
+//what the maze looks like from each side of the image: along every row (left, right) and column (top, bottom), how
+//deep the first wall cell lies and how many wall cells follow it. rows are scanned in parallel, columns 64 at a time
+struct wall_profiles_t {
+	static constexpr unsigned no_wall = UINT_MAX;
+	std::vector<unsigned> depth[4], thickness[4]; //0 = left, 1 = right, 2 = top, 3 = bottom
+};
+
+inline wall_profiles_t wall_profiles(const bit_grid_t& grid) {
+	const auto no_wall = wall_profiles_t::no_wall;
+	wall_profiles_t out;
+	auto& depth = out.depth;
+	auto& thickness = out.thickness;
+	for (int side = 0; side < 4; ++side) {
+		depth[side].assign(side < 2 ? grid.height : grid.width, no_wall);
+		thickness[side].assign(depth[side].size(), 0);
+	}
+	parallel_for(grid.height, [&](const size_t first_row, const size_t last_row) {
+		for (auto y = first_row; y < last_row; ++y) {
+			const auto row = grid.row(y);
+			auto wall = [&](const size_t x) { return !((row[x / 64] >> (x % 64)) & 1); };
+			for (size_t word = 0; word < grid.stride && depth[0][y] == no_wall; ++word) {
+				const auto valid = word + 1 < grid.stride || grid.width % 64 == 0 ? ~uint64_t(0) : (uint64_t(1) << (grid.width % 64)) - 1;
+				if (const auto walls = ~row[word] & valid) depth[0][y] = unsigned(word * 64 + ctz64(walls));
+			}
+			if (depth[0][y] == no_wall) continue;
+			auto x = size_t(depth[0][y]);
+			while (x < grid.width && wall(x)) ++x;
+			thickness[0][y] = unsigned(x - depth[0][y]);
+			auto last = grid.width - 1;
+			while (!wall(last)) --last;
+			depth[1][y] = grid.width - 1 - last;
+			auto from = last;
+			while (from > 0 && wall(from - 1)) --from;
+			thickness[1][y] = last - from + 1;
+		}
+	});
+	parallel_for(grid.stride, [&](const size_t first_word, const size_t last_word) { //columns, 64 at a time
+		for (auto word = first_word; word < last_word; ++word) {
+			const auto valid = word + 1 < grid.stride || grid.width % 64 == 0 ? ~uint64_t(0) : (uint64_t(1) << (grid.width % 64)) - 1;
+			for (int side = 2; side < 4; ++side) {
+				uint64_t found = 0, done = 0;
+				for (unsigned i = 0; i < grid.height && done != valid; ++i) {
+					const auto y = side == 2 ? i : grid.height - 1 - i;
+					const auto walls = ~grid.row(y)[word] & valid;
+					for (auto bits = walls & ~found; bits; bits &= bits - 1) depth[side][word * 64 + ctz64(bits)] = i;
+					found |= walls;
+					for (auto bits = found & ~done & ~walls; bits; bits &= bits - 1) {
+						const auto x = word * 64 + ctz64(bits);
+						thickness[side][x] = i - depth[side][x];
+					}
+					done |= found & ~walls;
+				}
+				for (auto bits = found & ~done; bits; bits &= bits - 1) { //walls that run to the far edge
+					const auto x = word * 64 + ctz64(bits);
+					thickness[side][x] = grid.height - depth[side][x];
+				}
+			}
+		}
+	});
+	return out;
+}
+
+//a gap in the maze's outer wall. at is an open cell inside the gap, in line with the wall
+struct opening_t {
+	point_t at;
+	unsigned width;
+};
+
+//looks at the maze from each side of the image: along every row (or column) the first wall cell is the outer wall,
+//except where the ray slips through a gap and hits a wall further in. a gap starts where a ray lands deeper than
+//the far face of its neighbour's wall, and ends where rays land back on the wall within a quarter of the side, which
+//works for mazes that fill the image as well as ones floating in a margin, round ones included (a slope too steep
+//to tell from a gap never lands back, and the side facing it sees the gap anyway). a gap seen from two sides is kept once
+inline std::vector<opening_t> find_openings(const bit_grid_t& grid) {
+	if (grid.width < 3 || grid.height < 3) return {};
+	const auto no_wall = wall_profiles_t::no_wall;
+	const auto profiles = wall_profiles(grid);
+	std::vector<opening_t> out;
+	for (int side = 0; side < 4; ++side) {
+		const auto& d = profiles.depth[side];
+		const auto& t = profiles.thickness[side];
+		const auto rays = d.size();
+		const auto length = side < 2 ? grid.width : grid.height;
+		const auto max_width = std::max<size_t>(2, rays / 4);
+		//the outer wall's usual thickness. a ray's own run can't stand in for it: beside a gap in a corner the
+		//neighbouring ray runs down the length of the perpendicular wall
+		std::vector<unsigned> runs;
+		for (size_t i = 0; i < rays; ++i)
+			if (d[i] != no_wall) runs.push_back(t[i]);
+		if (runs.empty()) continue;
+		std::nth_element(runs.begin(), runs.begin() + runs.size() / 2, runs.end());
+		const auto wall = runs[runs.size() / 2];
+		for (size_t i = 0; i + 1 < rays; ++i) {
+			if (d[i] == no_wall || (d[i + 1] != no_wall && d[i + 1] <= d[i] + wall)) continue; //no_wall: straight through the maze
+			const auto wall_face = d[i] + wall; //the far face of the outer wall next to the gap
+			auto end = i + 1;
+			while (end < rays && end - i <= max_width && (d[end] == no_wall || d[end] > wall_face)) ++end;
+			if (end == rays || end - i > max_width) continue; //the edge of the maze, not a gap in it
+			const auto middle = (i + 1 + end) / 2;
+			const auto along = std::min<size_t>(std::min<size_t>(d[middle], length) - 1, (d[i] + d[end]) / 2 + wall / 2);
+			point_t at;
+			switch (side) {
+			case 0: at = { int(along), int(middle) }; break;
+			case 1: at = { int(grid.width - 1 - along), int(middle) }; break;
+			case 2: at = { int(middle), int(along) }; break;
+			default: at = { int(middle), int(grid.height - 1 - along) }; break;
+			}
+			const auto width = unsigned(end - i - 1);
+			const auto seen = std::find_if(out.begin(), out.end(), [&](const opening_t& other) {
+				const auto dx = (long long)other.at.x - at.x, dy = (long long)other.at.y - at.y;
+				const auto reach = (long long)std::max(other.width, width);
+				return dx * dx + dy * dy <= reach * reach;
+			});
+			if (seen == out.end()) out.push_back({ at, width });
+			else if (width > seen->width) *seen = { at, width }; //the side that sees it head on sees it widest
+			i = end - 1;
+		}
+	}
+	return out;
+}
+
+//the two openings furthest apart, the one nearer the top left as the start. narrow gaps, like a break in an
+//antialiased line or a label touching the wall, lose to openings at least half as wide as the widest. returns how many
+//endpoints were set: with a single opening only the start is, since mazes like that usually end in the middle
+inline int propose_endpoints(const bit_grid_t& grid, point_t& start, point_t& end) {
+	auto openings = find_openings(grid);
+	if (openings.empty()) return 0;
+	const auto widest = std::max_element(openings.begin(), openings.end(), [](const opening_t& a, const opening_t& b) { return a.width < b.width; })->width;
+	openings.erase(std::remove_if(openings.begin(), openings.end(), [widest](const opening_t& o) { return o.width * 2 < widest; }), openings.end());
+	if (openings.size() == 1) {
+		start = openings.front().at;
+		return 1;
+	}
+	long long best = -1;
+	for (size_t a = 0; a < openings.size(); ++a)
+		for (auto b = a + 1; b < openings.size(); ++b) {
+			const auto dx = (long long)openings[a].at.x - openings[b].at.x, dy = (long long)openings[a].at.y - openings[b].at.y;
+			if (dx * dx + dy * dy <= best) continue;
+			best = dx * dx + dy * dy;
+			start = openings[a].at;
+			end = openings[b].at;
+		}
+	if (end.x + end.y < start.x + start.y) std::swap(start, end);
+	return 2;
+}
@@ -0,0 +1,223 @@
+#pragma once
+#include "includes.hpp"
+
+#include <unordered_map>
+
+class gl_resources;
+
+//a texture from gl_resources::shared(), handed back to it when this goes. rgba, width x height, clamped at the edges
+//and nearest when magnified, so pixels stay square and tiles meet without seams
+class gl_texture_t {
+	friend class gl_resources;
+	GLuint m_id = 0;
+	unsigned m_width = 0, m_height = 0;
+
+public:
+	gl_texture_t() = default;
+	gl_texture_t(gl_texture_t&& other) { *this = std::move(other); }
+	gl_texture_t& operator=(gl_texture_t&& other);
+	~gl_texture_t();
+
+	GLuint id() const { return m_id; }
+	explicit operator bool() const { return m_id != 0; }
+};
+
+//a pixel unpack buffer of some size, either a plain one to map each time or one mapped for good (mapped() stays
+//valid for its whole life)
+class gl_buffer_t {
+	friend class gl_resources;
+	GLuint m_id = 0;
+	size_t m_bytes = 0;
+	bool m_persistent = false;
+	void* m_mapped = nullptr;
+
+public:
+	gl_buffer_t() = default;
+	gl_buffer_t(gl_buffer_t&& other) { *this = std::move(other); }
+	gl_buffer_t& operator=(gl_buffer_t&& other);
+	~gl_buffer_t();
+
+	GLuint id() const { return m_id; }
+	void* mapped() const { return m_mapped; }
+	explicit operator bool() const { return m_id != 0; }
+};
+
+struct gl_stats_t {
+	size_t textures = 0, texture_bytes = 0; //held by a handle
+	size_t buffers = 0, buffer_bytes = 0;
+	size_t spare_textures = 0, spare_texture_bytes = 0; //given back and kept for reuse
+	size_t spare_buffers = 0, spare_buffer_bytes = 0;
+	size_t created = 0, reused = 0, deleted = 0; //objects, since start
+};
+
+//every texture and pixel buffer the viewer uses comes from here. one given back is kept, while the spares fit in
+//spare_budget bytes, for the next request of the same size, so panning and loading recycle objects instead of
+//making new ones; anything past that is deleted right away. only call it on the thread that owns the gl context,
+//and clear it before the context goes
+class gl_resources {
+	std::unordered_map<uint64_t, std::vector<GLuint>> m_spare_textures; //by width << 32 | height
+	std::unordered_map<uint64_t, std::vector<std::pair<GLuint, void*>>> m_spare_buffers; //by bytes << 1 | persistent
+	gl_stats_t m_stats;
+
+public:
+	size_t spare_budget = size_t(64) << 20;
+
+	gl_resources() = default;
+	gl_resources(const gl_resources&) = delete;
+	gl_resources& operator=(const gl_resources&) = delete;
+
+	static gl_resources& shared() {
+		static gl_resources resources;
+		return resources;
+	}
+
+	gl_texture_t texture(const unsigned width, const unsigned height) {
+		gl_texture_t out;
+		out.m_width = width;
+		out.m_height = height;
+		auto& spares = m_spare_textures[uint64_t(width) << 32 | height];
+		if (!spares.empty()) {
+			out.m_id = spares.back();
+			spares.pop_back();
+			--m_stats.spare_textures;
+			m_stats.spare_texture_bytes -= texture_bytes(width, height);
+			++m_stats.reused;
+		}
+		else {
+			glGenTextures(1, &out.m_id);
+			glBindTexture(GL_TEXTURE_2D, out.m_id);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+			glBindTexture(GL_TEXTURE_2D, 0);
+			++m_stats.created;
+		}
+		++m_stats.textures;
+		m_stats.texture_bytes += texture_bytes(width, height);
+		return out;
+	}
+
+	//a persistent buffer needs gl 4.4 or ARB_buffer_storage; an empty handle comes back when the driver refuses one
+	gl_buffer_t buffer(const size_t bytes, const bool persistent) {
+		gl_buffer_t out;
+		out.m_bytes = bytes;
+		out.m_persistent = persistent;
+		auto& spares = m_spare_buffers[uint64_t(bytes) << 1 | persistent];
+		if (!spares.empty()) {
+			out.m_id = spares.back().first;
+			out.m_mapped = spares.back().second;
+			spares.pop_back();
+			--m_stats.spare_buffers;
+			m_stats.spare_buffer_bytes -= bytes;
+			++m_stats.reused;
+		}
+		else {
+			glGenBuffers(1, &out.m_id);
+			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, out.m_id);
+			if (persistent) {
+				const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+				glBufferStorage(GL_PIXEL_UNPACK_BUFFER, bytes, nullptr, flags);
+				out.m_mapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, bytes, flags);
+			}
+			else glBufferData(GL_PIXEL_UNPACK_BUFFER, bytes, nullptr, GL_STREAM_DRAW);
+			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+			if (persistent && !out.m_mapped) {
+				glDeleteBuffers(1, &out.m_id);
+				out.m_id = 0;
+				return out;
+			}
+			++m_stats.created;
+		}
+		++m_stats.buffers;
+		m_stats.buffer_bytes += bytes;
+		return out;
+	}
+
+	//deletes every spare
+	void trim() {
+		for (auto& spares : m_spare_textures) {
+			glDeleteTextures(GLsizei(spares.second.size()), spares.second.data());
+			m_stats.deleted += spares.second.size();
+		}
+		for (auto& spares : m_spare_buffers)
+			for (const auto& spare : spares.second) {
+				glDeleteBuffers(1, &spare.first); //unmaps a persistent one too
+				++m_stats.deleted;
+			}
+		m_spare_textures.clear();
+		m_spare_buffers.clear();
+		m_stats.spare_textures = m_stats.spare_texture_bytes = m_stats.spare_buffers = m_stats.spare_buffer_bytes = 0;
+	}
+
+	const gl_stats_t& stats() const { return m_stats; }
+
+private:
+	friend class gl_texture_t;
+	friend class gl_buffer_t;
+
+	static size_t texture_bytes(const unsigned width, const unsigned height) { return size_t(width) * height * sizeof(rgba_t); }
+
+	void give_back(gl_texture_t& texture) {
+		const auto bytes = texture_bytes(texture.m_width, texture.m_height);
+		--m_stats.textures;
+		m_stats.texture_bytes -= bytes;
+		if (m_stats.spare_texture_bytes + m_stats.spare_buffer_bytes + bytes <= spare_budget) {
+			m_spare_textures[uint64_t(texture.m_width) << 32 | texture.m_height].push_back(texture.m_id);
+			++m_stats.spare_textures;
+			m_stats.spare_texture_bytes += bytes;
+		}
+		else {
+			glDeleteTextures(1, &texture.m_id);
+			++m_stats.deleted;
+		}
+		texture.m_id = 0;
+	}
+
+	void give_back(gl_buffer_t& buffer) {
+		--m_stats.buffers;
+		m_stats.buffer_bytes -= buffer.m_bytes;
+		if (m_stats.spare_texture_bytes + m_stats.spare_buffer_bytes + buffer.m_bytes <= spare_budget) {
+			m_spare_buffers[uint64_t(buffer.m_bytes) << 1 | buffer.m_persistent].push_back({ buffer.m_id, buffer.m_mapped });
+			++m_stats.spare_buffers;
+			m_stats.spare_buffer_bytes += buffer.m_bytes;
+		}
+		else {
+			glDeleteBuffers(1, &buffer.m_id);
+			++m_stats.deleted;
+		}
+		buffer.m_id = 0;
+		buffer.m_mapped = nullptr;
+	}
+};
+
+inline gl_texture_t& gl_texture_t::operator=(gl_texture_t&& other) {
+	if (this == &other) return *this;
+	if (m_id) gl_resources::shared().give_back(*this);
+	m_id = other.m_id;
+	m_width = other.m_width;
+	m_height = other.m_height;
+	other.m_id = 0;
+	return *this;
+}
+
+inline gl_texture_t::~gl_texture_t() {
+	if (m_id) gl_resources::shared().give_back(*this);
+}
+
+inline gl_buffer_t& gl_buffer_t::operator=(gl_buffer_t&& other) {
+	if (this == &other) return *this;
+	if (m_id) gl_resources::shared().give_back(*this);
+	m_id = other.m_id;
+	m_bytes = other.m_bytes;
+	m_persistent = other.m_persistent;
+	m_mapped = other.m_mapped;
+	other.m_id = 0;
+	other.m_mapped = nullptr;
+	return *this;
+}
+
+inline gl_buffer_t::~gl_buffer_t() {
+	if (m_id) gl_resources::shared().give_back(*this);
+}
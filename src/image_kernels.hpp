@@ -0,0 +1,418 @@
+#pragma once
+#include "includes.hpp"
+#include <chrono>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define KERNELS_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define KERNEL_TARGET(x)
+#else
+#define KERNEL_TARGET(x) __attribute__((target(x)))
+#endif
+#endif
+
+//row kernels for whole-image passes. every kernel works on one row of `count` pixels, so callers stay row-major
+//and bit output lines up with bit_grid_t rows. one implementation per instruction set, picked once at runtime
+struct image_kernels_t {
+	const char* name;
+	void (*luminance)(const rgba_t* in, uint8_t* out, size_t count);
+	void (*binarize)(const rgba_t* in, uint64_t* out, size_t count, int threshold); //bit set when luminance > threshold
+	void (*binarize_plane)(const uint8_t* in, uint64_t* out, size_t count, int threshold); //same, from 8-bit luminance
+	void (*expand)(const uint64_t* in, rgba_t* out, size_t count, rgba_t set, rgba_t clear);
+	void (*replace)(rgba_t* pixels, size_t count, rgba_t from, rgba_t to);
+	void (*colormap)(const unsigned* in, rgba_t* out, size_t count, const rgba_t* lut, float scale, bool log); //see colormap_scalar
+};
+
+//relative luminance = 0.2126R + 0.7152G + 0.0722B, in 1.15 fixed point so the weights sum to exactly 1 << 15
+constexpr int luma_r = 6966, luma_g = 23436, luma_b = 2366;
+
+inline uint8_t pixel_luminance(const rgba_t p) { return uint8_t((p.r * luma_r + p.g * luma_g + p.b * luma_b) >> 15); }
+
+inline uint32_t pixel_bits(const rgba_t p) { uint32_t out; memcpy(&out, &p, sizeof(out)); return out; }
+
+inline void luminance_scalar(const rgba_t* in, uint8_t* out, const size_t count) {
+	for (size_t i = 0; i < count; ++i) out[i] = pixel_luminance(in[i]);
+}
+
+inline void binarize_scalar(const rgba_t* in, uint64_t* out, const size_t count, const int threshold) {
+	for (size_t word = 0; word * 64 < count; ++word) {
+		uint64_t bits = 0;
+		const auto n = std::min<size_t>(64, count - word * 64);
+		for (size_t i = 0; i < n; ++i)
+			bits |= uint64_t(pixel_luminance(in[word * 64 + i]) > threshold) << i;
+		out[word] = bits;
+	}
+}
+
+inline void binarize_plane_scalar(const uint8_t* in, uint64_t* out, const size_t count, const int threshold) {
+	for (size_t word = 0; word * 64 < count; ++word) {
+		uint64_t bits = 0;
+		const auto n = std::min<size_t>(64, count - word * 64);
+		for (size_t i = 0; i < n; ++i)
+			bits |= uint64_t(in[word * 64 + i] > threshold) << i;
+		out[word] = bits;
+	}
+}
+
+inline void expand_scalar(const uint64_t* in, rgba_t* out, const size_t count, const rgba_t set, const rgba_t clear) {
+	for (size_t i = 0; i < count; ++i) out[i] = (in[i / 64] >> (i % 64) & 1) ? set : clear;
+}
+
+inline void replace_scalar(rgba_t* pixels, const size_t count, const rgba_t from, const rgba_t to) {
+	for (size_t i = 0; i < count; ++i)
+		if (pixels[i] == from) pixels[i] = to;
+}
+
+constexpr int colormap_size = 4096;
+
+//what a cost is scaled by before it indexes the colormap: the cost itself, or with log set the bits of float(cost + 1)
+//above those of 1.f, which is log2(cost + 1) * 2^23 up to a piecewise linear error
+inline float colormap_key(const unsigned cost, const bool log) {
+	const auto f = float(int(cost));
+	if (!log) return f;
+	const auto shifted = f + 1.f;
+	uint32_t bits;
+	memcpy(&bits, &shifted, sizeof(bits));
+	return float(int(bits - 0x3F800000));
+}
+
+//costs to colours, lut[key * scale] clamped to the colormap_size entries of lut. unreached cells (UINT_MAX) come out
+//transparent. every version rounds the same way, so they all give the same pixels
+inline void colormap_scalar(const unsigned* in, rgba_t* out, const size_t count, const rgba_t* lut, const float scale, const bool log) {
+	for (size_t i = 0; i < count; ++i)
+		out[i] = in[i] == UINT_MAX ? rgba_t{ 0, 0, 0, 0 } : lut[int(std::min(std::max(colormap_key(in[i], log) * scale, 0.f), float(colormap_size - 1)))];
+}
+
+#ifdef KERNELS_X86
+KERNEL_TARGET("sse2") inline __m128i luminance_sse2(const __m128i pixels) { //4 pixels in, 4 32-bit luminances out
+	const auto mask = _mm_set1_epi32(0x00FF00FF);
+	const auto rb = _mm_and_si128(pixels, mask), ga = _mm_and_si128(_mm_srli_epi32(pixels, 8), mask);
+	const auto sum = _mm_add_epi32(_mm_madd_epi16(rb, _mm_set1_epi32(luma_b << 16 | luma_r)), _mm_madd_epi16(ga, _mm_set1_epi32(luma_g)));
+	return _mm_srli_epi32(sum, 15);
+}
+
+KERNEL_TARGET("sse2") inline void luminance_sse2(const rgba_t* in, uint8_t* out, const size_t count) {
+	size_t i = 0;
+	for (; i + 16 <= count; i += 16) {
+		const auto a = luminance_sse2(_mm_loadu_si128((const __m128i*)(in + i)));
+		const auto b = luminance_sse2(_mm_loadu_si128((const __m128i*)(in + i + 4)));
+		const auto c = luminance_sse2(_mm_loadu_si128((const __m128i*)(in + i + 8)));
+		const auto d = luminance_sse2(_mm_loadu_si128((const __m128i*)(in + i + 12)));
+		_mm_storeu_si128((__m128i*)(out + i), _mm_packus_epi16(_mm_packs_epi32(a, b), _mm_packs_epi32(c, d)));
+	}
+	luminance_scalar(in + i, out + i, count - i);
+}
+
+KERNEL_TARGET("sse2") inline void binarize_sse2(const rgba_t* in, uint64_t* out, const size_t count, const int threshold) {
+	const auto limit = _mm_set1_epi32(threshold);
+	size_t word = 0;
+	for (; word * 64 + 64 <= count; ++word) {
+		uint64_t bits = 0;
+		for (int i = 0; i < 64; i += 4) {
+			const auto lum = luminance_sse2(_mm_loadu_si128((const __m128i*)(in + word * 64 + i)));
+			bits |= uint64_t(_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(lum, limit)))) << i;
+		}
+		out[word] = bits;
+	}
+	if (word * 64 < count) binarize_scalar(in + word * 64, out + word, count - word * 64, threshold);
+}
+
+KERNEL_TARGET("sse2") inline void binarize_plane_sse2(const uint8_t* in, uint64_t* out, const size_t count, const int threshold) {
+	if (threshold < 0 || threshold > 254) return binarize_plane_scalar(in, out, count, threshold); //no signed byte compare covers these
+	const auto flip = _mm_set1_epi8(char(0x80)), limit = _mm_set1_epi8(char(threshold ^ 0x80)); //unsigned > via signed compare
+	size_t word = 0;
+	for (; word * 64 + 64 <= count; ++word) {
+		uint64_t bits = 0;
+		for (int i = 0; i < 64; i += 16) {
+			const auto v = _mm_xor_si128(_mm_loadu_si128((const __m128i*)(in + word * 64 + i)), flip);
+			bits |= uint64_t(uint32_t(_mm_movemask_epi8(_mm_cmpgt_epi8(v, limit)))) << i;
+		}
+		out[word] = bits;
+	}
+	if (word * 64 < count) binarize_plane_scalar(in + word * 64, out + word, count - word * 64, threshold);
+}
+
+KERNEL_TARGET("sse2") inline void expand_sse2(const uint64_t* in, rgba_t* out, const size_t count, const rgba_t set, const rgba_t clear) {
+	const auto on = _mm_set1_epi32(pixel_bits(set)), off = _mm_set1_epi32(pixel_bits(clear));
+	const auto lanes = _mm_setr_epi32(1, 2, 4, 8);
+	size_t i = 0;
+	for (; i + 4 <= count; i += 4) {
+		const auto nibble = _mm_set1_epi32(int(in[i / 64] >> (i % 64)) & 0xF);
+		const auto mask = _mm_cmpeq_epi32(_mm_and_si128(nibble, lanes), lanes);
+		_mm_storeu_si128((__m128i*)(out + i), _mm_or_si128(_mm_and_si128(mask, on), _mm_andnot_si128(mask, off)));
+	}
+	for (; i < count; ++i) out[i] = (in[i / 64] >> (i % 64) & 1) ? set : clear;
+}
+
+KERNEL_TARGET("sse2") inline void replace_sse2(rgba_t* pixels, const size_t count, const rgba_t from, const rgba_t to) {
+	const auto match = _mm_set1_epi32(pixel_bits(from)), with = _mm_set1_epi32(pixel_bits(to));
+	size_t i = 0;
+	for (; i + 4 <= count; i += 4) {
+		const auto v = _mm_loadu_si128((const __m128i*)(pixels + i));
+		const auto mask = _mm_cmpeq_epi32(v, match);
+		_mm_storeu_si128((__m128i*)(pixels + i), _mm_or_si128(_mm_and_si128(mask, with), _mm_andnot_si128(mask, v)));
+	}
+	replace_scalar(pixels + i, count - i, from, to);
+}
+
+KERNEL_TARGET("sse2") inline void colormap_sse2(const unsigned* in, rgba_t* out, const size_t count, const rgba_t* lut, const float scale, const bool log) {
+	const auto one = _mm_set1_ps(1.f), by = _mm_set1_ps(scale), top = _mm_set1_ps(float(colormap_size - 1));
+	const auto bias = _mm_set1_epi32(0x3F800000);
+	size_t i = 0;
+	for (; i + 4 <= count; i += 4) { //no gather before avx2, so only the indices are vectorized
+		auto key = _mm_cvtepi32_ps(_mm_loadu_si128((const __m128i*)(in + i)));
+		if (log) key = _mm_cvtepi32_ps(_mm_sub_epi32(_mm_castps_si128(_mm_add_ps(key, one)), bias));
+		alignas(16) int index[4];
+		_mm_store_si128((__m128i*)index, _mm_cvttps_epi32(_mm_min_ps(_mm_max_ps(_mm_mul_ps(key, by), _mm_setzero_ps()), top)));
+		for (int lane = 0; lane < 4; ++lane) out[i + lane] = in[i + lane] == UINT_MAX ? rgba_t{ 0, 0, 0, 0 } : lut[index[lane]];
+	}
+	colormap_scalar(in + i, out + i, count - i, lut, scale, log);
+}
+
+KERNEL_TARGET("avx2") inline __m256i luminance_avx2(const __m256i pixels) {
+	const auto mask = _mm256_set1_epi32(0x00FF00FF);
+	const auto rb = _mm256_and_si256(pixels, mask), ga = _mm256_and_si256(_mm256_srli_epi32(pixels, 8), mask);
+	const auto sum = _mm256_add_epi32(_mm256_madd_epi16(rb, _mm256_set1_epi32(luma_b << 16 | luma_r)), _mm256_madd_epi16(ga, _mm256_set1_epi32(luma_g)));
+	return _mm256_srli_epi32(sum, 15);
+}
+
+KERNEL_TARGET("avx2") inline void luminance_avx2(const rgba_t* in, uint8_t* out, const size_t count) {
+	const auto order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7); //packs work per 128-bit lane, this undoes the interleave
+	size_t i = 0;
+	for (; i + 32 <= count; i += 32) {
+		const auto a = luminance_avx2(_mm256_loadu_si256((const __m256i*)(in + i)));
+		const auto b = luminance_avx2(_mm256_loadu_si256((const __m256i*)(in + i + 8)));
+		const auto c = luminance_avx2(_mm256_loadu_si256((const __m256i*)(in + i + 16)));
+		const auto d = luminance_avx2(_mm256_loadu_si256((const __m256i*)(in + i + 24)));
+		const auto packed = _mm256_packus_epi16(_mm256_packs_epi32(a, b), _mm256_packs_epi32(c, d));
+		_mm256_storeu_si256((__m256i*)(out + i), _mm256_permutevar8x32_epi32(packed, order));
+	}
+	luminance_sse2(in + i, out + i, count - i);
+}
+
+KERNEL_TARGET("avx2") inline void binarize_avx2(const rgba_t* in, uint64_t* out, const size_t count, const int threshold) {
+	const auto limit = _mm256_set1_epi32(threshold);
+	size_t word = 0;
+	for (; word * 64 + 64 <= count; ++word) {
+		uint64_t bits = 0;
+		for (int i = 0; i < 64; i += 8) {
+			const auto lum = luminance_avx2(_mm256_loadu_si256((const __m256i*)(in + word * 64 + i)));
+			bits |= uint64_t(uint32_t(_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(lum, limit))))) << i;
+		}
+		out[word] = bits;
+	}
+	if (word * 64 < count) binarize_scalar(in + word * 64, out + word, count - word * 64, threshold);
+}
+
+KERNEL_TARGET("avx2") inline void binarize_plane_avx2(const uint8_t* in, uint64_t* out, const size_t count, const int threshold) {
+	if (threshold < 0 || threshold > 254) return binarize_plane_scalar(in, out, count, threshold);
+	const auto flip = _mm256_set1_epi8(char(0x80)), limit = _mm256_set1_epi8(char(threshold ^ 0x80));
+	size_t word = 0;
+	for (; word * 64 + 64 <= count; ++word) {
+		const auto lo = _mm256_xor_si256(_mm256_loadu_si256((const __m256i*)(in + word * 64)), flip);
+		const auto hi = _mm256_xor_si256(_mm256_loadu_si256((const __m256i*)(in + word * 64 + 32)), flip);
+		out[word] = uint64_t(uint32_t(_mm256_movemask_epi8(_mm256_cmpgt_epi8(lo, limit))))
+			| uint64_t(uint32_t(_mm256_movemask_epi8(_mm256_cmpgt_epi8(hi, limit)))) << 32;
+	}
+	if (word * 64 < count) binarize_plane_scalar(in + word * 64, out + word, count - word * 64, threshold);
+}
+
+KERNEL_TARGET("avx2") inline void expand_avx2(const uint64_t* in, rgba_t* out, const size_t count, const rgba_t set, const rgba_t clear) {
+	const auto on = _mm256_set1_epi32(pixel_bits(set)), off = _mm256_set1_epi32(pixel_bits(clear));
+	const auto lanes = _mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128);
+	size_t i = 0;
+	for (; i + 8 <= count; i += 8) {
+		const auto byte = _mm256_set1_epi32(int(in[i / 64] >> (i % 64)) & 0xFF);
+		const auto mask = _mm256_cmpeq_epi32(_mm256_and_si256(byte, lanes), lanes);
+		_mm256_storeu_si256((__m256i*)(out + i), _mm256_blendv_epi8(off, on, mask));
+	}
+	for (; i < count; ++i) out[i] = (in[i / 64] >> (i % 64) & 1) ? set : clear;
+}
+
+KERNEL_TARGET("avx2") inline void replace_avx2(rgba_t* pixels, const size_t count, const rgba_t from, const rgba_t to) {
+	const auto match = _mm256_set1_epi32(pixel_bits(from)), with = _mm256_set1_epi32(pixel_bits(to));
+	size_t i = 0;
+	for (; i + 8 <= count; i += 8) {
+		const auto v = _mm256_loadu_si256((const __m256i*)(pixels + i));
+		_mm256_storeu_si256((__m256i*)(pixels + i), _mm256_blendv_epi8(v, with, _mm256_cmpeq_epi32(v, match)));
+	}
+	replace_scalar(pixels + i, count - i, from, to);
+}
+
+KERNEL_TARGET("avx2") inline void colormap_avx2(const unsigned* in, rgba_t* out, const size_t count, const rgba_t* lut, const float scale, const bool log) {
+	const auto one = _mm256_set1_ps(1.f), by = _mm256_set1_ps(scale), top = _mm256_set1_ps(float(colormap_size - 1));
+	const auto bias = _mm256_set1_epi32(0x3F800000), unreached = _mm256_set1_epi32(-1);
+	size_t i = 0;
+	for (; i + 8 <= count; i += 8) {
+		const auto cost = _mm256_loadu_si256((const __m256i*)(in + i));
+		auto key = _mm256_cvtepi32_ps(cost);
+		if (log) key = _mm256_cvtepi32_ps(_mm256_sub_epi32(_mm256_castps_si256(_mm256_add_ps(key, one)), bias));
+		const auto index = _mm256_cvttps_epi32(_mm256_min_ps(_mm256_max_ps(_mm256_mul_ps(key, by), _mm256_setzero_ps()), top));
+		const auto color = _mm256_i32gather_epi32((const int*)lut, index, 4);
+		_mm256_storeu_si256((__m256i*)(out + i), _mm256_andnot_si256(_mm256_cmpeq_epi32(cost, unreached), color));
+	}
+	colormap_scalar(in + i, out + i, count - i, lut, scale, log);
+}
+
+KERNEL_TARGET("avx512f,avx512bw") inline __m512i luminance_avx512(const __m512i pixels) {
+	const auto mask = _mm512_set1_epi32(0x00FF00FF);
+	const auto rb = _mm512_and_si512(pixels, mask), ga = _mm512_and_si512(_mm512_srli_epi32(pixels, 8), mask);
+	const auto sum = _mm512_add_epi32(_mm512_madd_epi16(rb, _mm512_set1_epi32(luma_b << 16 | luma_r)), _mm512_madd_epi16(ga, _mm512_set1_epi32(luma_g)));
+	return _mm512_srli_epi32(sum, 15);
+}
+
+KERNEL_TARGET("avx512f,avx512bw") inline void luminance_avx512(const rgba_t* in, uint8_t* out, const size_t count) {
+	size_t i = 0;
+	for (; i + 16 <= count; i += 16)
+		_mm_storeu_si128((__m128i*)(out + i), _mm512_cvtepi32_epi8(luminance_avx512(_mm512_loadu_si512(in + i))));
+	luminance_scalar(in + i, out + i, count - i);
+}
+
+KERNEL_TARGET("avx512f,avx512bw") inline void binarize_avx512(const rgba_t* in, uint64_t* out, const size_t count, const int threshold) {
+	const auto limit = _mm512_set1_epi32(threshold);
+	size_t word = 0;
+	for (; word * 64 + 64 <= count; ++word) {
+		uint64_t bits = 0;
+		for (int i = 0; i < 64; i += 16)
+			bits |= uint64_t(_mm512_cmpgt_epi32_mask(luminance_avx512(_mm512_loadu_si512(in + word * 64 + i)), limit)) << i;
+		out[word] = bits;
+	}
+	if (word * 64 < count) binarize_scalar(in + word * 64, out + word, count - word * 64, threshold);
+}
+
+KERNEL_TARGET("avx512f,avx512bw") inline void binarize_plane_avx512(const uint8_t* in, uint64_t* out, const size_t count, const int threshold) {
+	if (threshold < 0 || threshold > 254) return binarize_plane_scalar(in, out, count, threshold);
+	const auto limit = _mm512_set1_epi8(char(threshold));
+	size_t word = 0;
+	for (; word * 64 + 64 <= count; ++word)
+		out[word] = _mm512_cmpgt_epu8_mask(_mm512_loadu_si512(in + word * 64), limit);
+	if (word * 64 < count) binarize_plane_scalar(in + word * 64, out + word, count - word * 64, threshold);
+}
+
+KERNEL_TARGET("avx512f,avx512bw") inline void expand_avx512(const uint64_t* in, rgba_t* out, const size_t count, const rgba_t set, const rgba_t clear) {
+	const auto on = _mm512_set1_epi32(pixel_bits(set)), off = _mm512_set1_epi32(pixel_bits(clear));
+	size_t i = 0;
+	for (; i + 16 <= count; i += 16)
+		_mm512_storeu_si512(out + i, _mm512_mask_blend_epi32(__mmask16(in[i / 64] >> (i % 64)), off, on));
+	for (; i < count; ++i) out[i] = (in[i / 64] >> (i % 64) & 1) ? set : clear;
+}
+
+KERNEL_TARGET("avx512f,avx512bw") inline void replace_avx512(rgba_t* pixels, const size_t count, const rgba_t from, const rgba_t to) {
+	const auto match = _mm512_set1_epi32(pixel_bits(from)), with = _mm512_set1_epi32(pixel_bits(to));
+	size_t i = 0;
+	for (; i + 16 <= count; i += 16) {
+		const auto v = _mm512_loadu_si512(pixels + i);
+		_mm512_storeu_si512(pixels + i, _mm512_mask_mov_epi32(v, _mm512_cmpeq_epi32_mask(v, match), with));
+	}
+	replace_scalar(pixels + i, count - i, from, to);
+}
+
+KERNEL_TARGET("avx512f,avx512bw") inline void colormap_avx512(const unsigned* in, rgba_t* out, const size_t count, const rgba_t* lut, const float scale, const bool log) {
+	const auto one = _mm512_set1_ps(1.f), by = _mm512_set1_ps(scale), top = _mm512_set1_ps(float(colormap_size - 1));
+	const auto bias = _mm512_set1_epi32(0x3F800000), unreached = _mm512_set1_epi32(-1);
+	size_t i = 0;
+	for (; i + 16 <= count; i += 16) {
+		const auto cost = _mm512_loadu_si512(in + i);
+		auto key = _mm512_cvtepi32_ps(cost);
+		if (log) key = _mm512_cvtepi32_ps(_mm512_sub_epi32(_mm512_castps_si512(_mm512_add_ps(key, one)), bias));
+		const auto index = _mm512_cvttps_epi32(_mm512_min_ps(_mm512_max_ps(_mm512_mul_ps(key, by), _mm512_setzero_ps()), top));
+		const auto reached = _mm512_cmpneq_epi32_mask(cost, unreached);
+		_mm512_storeu_si512(out + i, _mm512_mask_i32gather_epi32(_mm512_setzero_si512(), reached, index, lut, 4));
+	}
+	colormap_scalar(in + i, out + i, count - i, lut, scale, log);
+}
+#endif
+
+//every kernel set this cpu can run, slowest first
+inline std::vector<image_kernels_t> available_kernels() {
+	std::vector<image_kernels_t> out = { { "scalar", luminance_scalar, binarize_scalar, binarize_plane_scalar, expand_scalar, replace_scalar, colormap_scalar } };
+#ifdef KERNELS_X86
+	auto sse2 = true, avx2 = false, avx512 = false;
+#ifdef _MSC_VER
+	int info[4];
+	__cpuid(info, 0);
+	const auto max_leaf = info[0];
+	__cpuid(info, 1);
+	sse2 = info[3] & (1 << 26);
+	const auto xcr0 = (info[2] & (1 << 27)) ? _xgetbv(0) : 0; //which register files the os saves
+	if (max_leaf >= 7) {
+		__cpuidex(info, 7, 0);
+		avx2 = (info[1] & (1 << 5)) && (xcr0 & 0x6) == 0x6;
+		avx512 = (info[1] & (1 << 16)) && (info[1] & (1 << 30)) && (xcr0 & 0xE6) == 0xE6;
+	}
+#else
+	__builtin_cpu_init();
+	sse2 = __builtin_cpu_supports("sse2");
+	avx2 = __builtin_cpu_supports("avx2");
+	avx512 = __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw");
+#endif
+	if (sse2) out.push_back({ "sse2", luminance_sse2, binarize_sse2, binarize_plane_sse2, expand_sse2, replace_sse2, colormap_sse2 });
+	if (avx2) out.push_back({ "avx2", luminance_avx2, binarize_avx2, binarize_plane_avx2, expand_avx2, replace_avx2, colormap_avx2 });
+	if (avx512) out.push_back({ "avx-512", luminance_avx512, binarize_avx512, binarize_plane_avx512, expand_avx512, replace_avx512, colormap_avx512 });
+#endif
+	return out;
+}
+
+inline const image_kernels_t& image_kernels() {
+	static const auto best = available_kernels().back();
+	return best;
+}
+
+struct kernel_benchmark_t {
+	std::string kernels, kernel;
+	double pixels_per_second;
+};
+
+//times every kernel of every available set on a synthetic 2048x2048 image
+inline std::vector<kernel_benchmark_t> benchmark_kernels() {
+	constexpr size_t width = 2048, height = 2048;
+	std::vector<rgba_t> pixels(width * height), scratch(width * height);
+	for (size_t i = 0; i < pixels.size(); ++i) {
+		const auto v = uint8_t(i * 2654435761u >> 24);
+		pixels[i] = { v, uint8_t(v ^ 0x5A), uint8_t(v + 31), 0xFF };
+	}
+	std::vector<uint8_t> luminance(width * height);
+	std::vector<uint64_t> bits((width + 63) / 64 * height);
+	std::vector<unsigned> costs(width * height);
+	for (size_t i = 0; i < costs.size(); ++i) costs[i] = i % 97 == 0 ? UINT_MAX : unsigned(i);
+	std::vector<rgba_t> lut(colormap_size);
+	for (int i = 0; i < colormap_size; ++i) lut[i] = { uint8_t(i >> 4), uint8_t(i >> 4), uint8_t(i >> 4), 0xFF };
+
+	auto time = [&](auto&& pass) { //repeats whole-image passes for at least 50ms
+		const auto begin = std::chrono::steady_clock::now();
+		size_t passes = 0;
+		double elapsed = 0;
+		do {
+			pass();
+			++passes;
+			elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+		} while (elapsed < 0.05);
+		return double(passes * width * height) / elapsed;
+	};
+
+	std::vector<kernel_benchmark_t> out;
+	for (const auto& k : available_kernels()) {
+		const auto stride = (width + 63) / 64;
+		out.push_back({ k.name, "luminance", time([&] {
+			for (size_t y = 0; y < height; ++y) k.luminance(&pixels[y * width], &luminance[y * width], width);
+		}) });
+		out.push_back({ k.name, "binarize", time([&] {
+			for (size_t y = 0; y < height; ++y) k.binarize(&pixels[y * width], &bits[y * stride], width, 200);
+		}) });
+		out.push_back({ k.name, "binarize8", time([&] {
+			for (size_t y = 0; y < height; ++y) k.binarize_plane(&luminance[y * width], &bits[y * stride], width, 200);
+		}) });
+		out.push_back({ k.name, "expand", time([&] {
+			for (size_t y = 0; y < height; ++y) k.expand(&bits[y * stride], &scratch[y * width], width, { 0xFF, 0xFF, 0xFF, 0xFF }, { 0x00, 0x00, 0x00, 0xFF });
+		}) });
+		out.push_back({ k.name, "replace", time([&] {
+			for (size_t y = 0; y < height; ++y) k.replace(&scratch[y * width], width, { 0xFF, 0xFF, 0xFF, 0xFF }, { 0x80, 0x80, 0x80, 0xFF });
+		}) });
+		out.push_back({ k.name, "colormap", time([&] {
+			for (size_t y = 0; y < height; ++y) k.colormap(&costs[y * width], &scratch[y * width], width, lut.data(), float(colormap_size) / (width * height), false);
+		}) });
+	}
+	return out;
+}
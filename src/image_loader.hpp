@@ -0,0 +1,258 @@
+#pragma once
+#include "includes.hpp"
+#include "image_kernels.hpp"
+#include "netpbm.hpp"
+#include "maze_file.hpp"
+#include "thresholding.hpp"
+#include "morphology.hpp"
+#include "tiled_view.hpp"
+
+#include <array>
+
+struct luminance_image_t {
+	unsigned width = 0, height = 0;
+	std::vector<uint8_t> pixels; //row-major, one byte per pixel
+};
+
+//decodes a file for solving, where only luminance matters. greyscale files ask stb_image for one channel, which is
+//already their luminance. stb_image has no row callback, so colour files still decode to rgba once, but each row is
+//reduced as soon as the decode returns and the rgba buffer is freed before the caller gets anything
+template <typename F>
+bool decode_for_solving(const char* filename, unsigned& width, unsigned& height, F&& on_rows) {
+	int w = 0, h = 0, channels = 0;
+	if (!stbi_info(filename, &w, &h, &channels)) return false;
+	const auto grey = channels <= 2;
+	unsigned char* data = stbi_load(filename, &w, &h, nullptr, grey ? 1 : 4);
+	if (data == NULL) return false;
+	width = w;
+	height = h;
+	parallel_for(h, [&](const size_t first_row, const size_t last_row) {
+		for (auto y = first_row; y < last_row; ++y) {
+			if (grey) on_rows(y, (const uint8_t*)data + y * w, (const rgba_t*)nullptr);
+			else on_rows(y, (const uint8_t*)nullptr, (const rgba_t*)data + y * w);
+		}
+	});
+	stbi_image_free(data);
+	return true;
+}
+
+//when colour is given and the file has colour, it gets the rgba pixels too, from the same single decode
+bool load_luminance_from_file(const char* filename, luminance_image_t& out, std::vector<rgba_t>* colour = nullptr) {
+	if (is_maze_file(filename)) {
+		maze_file_t maze_file;
+		if (!maze_file.open(filename)) return false;
+		out.width = maze_file.width();
+		out.height = maze_file.height();
+		if (maze_file.has_luminance()) {
+			maze_file.read_luminance(0, 0, out.width, out.height, out.pixels);
+			return true;
+		}
+		bit_grid_t grid; //saved without luminance, the grid is all there is
+		maze_file.read_grid(0, 0, out.width, out.height, grid);
+		out.pixels.resize(size_t(out.width) * out.height);
+		parallel_for(out.height, [&](const size_t first_row, const size_t last_row) {
+			for (auto y = first_row; y < last_row; ++y)
+				for (size_t x = 0; x < out.width; ++x) out.pixels[y * out.width + x] = grid.at(x, y) ? 0xFF : 0x00;
+		});
+		return true;
+	}
+
+	if (is_netpbm_file(filename)) {
+		netpbm_t pbm;
+		if (!pbm.open(filename)) return false;
+		out.width = pbm.width;
+		out.height = pbm.height;
+		out.pixels.resize(size_t(pbm.width) * pbm.height);
+		parallel_for(pbm.height, [&](const size_t first_row, const size_t last_row) {
+			for (auto y = first_row; y < last_row; ++y) pbm.luminance_row(y, &out.pixels[y * pbm.width]);
+		});
+		return true;
+	}
+
+	const auto& kernels = image_kernels();
+	int w = 0, h = 0, channels = 0;
+	if (!stbi_info(filename, &w, &h, &channels)) return false;
+	out.pixels.resize(size_t(w) * h);
+	if (colour && channels > 2) {
+		unsigned char* data = stbi_load(filename, &w, &h, nullptr, 4);
+		if (data == NULL) return false;
+		out.width = w;
+		out.height = h;
+		colour->assign((const rgba_t*)data, (const rgba_t*)data + size_t(w) * h);
+		stbi_image_free(data);
+		parallel_for(out.height, [&](const size_t first_row, const size_t last_row) {
+			for (auto y = first_row; y < last_row; ++y) kernels.luminance(&(*colour)[y * out.width], &out.pixels[y * out.width], out.width);
+		});
+		return true;
+	}
+	return decode_for_solving(filename, out.width, out.height, [&](const size_t y, const uint8_t* grey, const rgba_t* rgba) {
+		if (grey) memcpy(&out.pixels[y * out.width], grey, out.width);
+		else kernels.luminance(rgba, &out.pixels[y * out.width], out.width);
+	});
+}
+
+//binarizes straight into the packed grid, no 8-bit plane is kept, then runs cleanup on it
+bool load_grid_from_file(const char* filename, const int threshold, bit_grid_t& out, const cleanup_t& cleanup = {}) {
+	const auto& kernels = image_kernels();
+	if (is_maze_file(filename)) { //the stored grid is used as is unless its luminance is kept and asked for another way
+		maze_file_t maze_file;
+		if (!maze_file.open(filename)) return false;
+		const auto saved = maze_file.binarization();
+		const auto same_binarize = saved.method == binarize_method_t::global && threshold == saved.threshold;
+		if ((same_binarize && cleanup == saved.cleanup) || !maze_file.has_luminance()) {
+			maze_file.read_grid(0, 0, maze_file.width(), maze_file.height(), out);
+			if (cleanup != saved.cleanup && cleanup.op != morph_op_t::none) out = cleanup.apply(out); //the stored grid is already cleaned its own way
+			return true;
+		}
+		out = bit_grid_t(maze_file.width(), maze_file.height());
+		parallel_for(out.height, [&](const size_t first_row, const size_t last_row) {
+			for (auto y = first_row; y < last_row; ++y) kernels.binarize_plane(maze_file.luminance_row(y), out.row(y), out.width, threshold);
+		});
+	}
+	else if (is_netpbm_file(filename)) {
+		netpbm_t pbm;
+		if (!pbm.open(filename)) return false;
+		pbm.to_grid(threshold, out);
+	}
+	else {
+		int w = 0, h = 0, channels = 0;
+		if (!stbi_info(filename, &w, &h, &channels)) return false;
+		out = bit_grid_t(w, h);
+		unsigned width, height;
+		const auto decoded = decode_for_solving(filename, width, height, [&](const size_t y, const uint8_t* grey, const rgba_t* rgba) {
+			if (grey) kernels.binarize_plane(grey, out.row(y), width, threshold);
+			else kernels.binarize(rgba, out.row(y), width, threshold);
+		});
+		if (!decoded) return false;
+	}
+	if (cleanup.op != morph_op_t::none) out = cleanup.apply(out);
+	return true;
+}
+
+//start and end saved with a .maze file, false for every other format
+bool load_saved_endpoints(const char* filename, point_t& start, point_t& end) {
+	maze_file_t maze_file;
+	if (!is_maze_file(filename) || !maze_file.open(filename)) return false;
+	start = maze_file.start();
+	end = maze_file.end();
+	return true;
+}
+
+//how the grid saved with a .maze file was binarized, false for every other format
+bool load_saved_binarization(const char* filename, binarization_t& out) {
+	maze_file_t maze_file;
+	if (!is_maze_file(filename) || !maze_file.open(filename)) return false;
+	out = maze_file.binarization();
+	return true;
+}
+
+//the image being worked on, decoded once when it's chosen. every solve binarizes the cached luminance, and the grid
+//of the last threshold is kept so solving again at the same threshold does no image work at all
+struct source_image_t {
+	std::string file_name;
+	luminance_image_t luminance;
+	std::array<uint64_t, 256> histogram = {}; //pixels per luminance value
+
+	//colour, when given, gets a colour file's rgba pixels for showing, decoded along with the luminance
+	bool load(const std::string& name, std::vector<rgba_t>* colour = nullptr) {
+		luminance_image_t decoded;
+		if (!load_luminance_from_file(name.c_str(), decoded, colour)) return false;
+		file_name = name;
+		assign(std::move(decoded));
+		maze_file_t maze_file; //a saved grid is what comes back at its settings, not a fresh binarization of the luminance
+		if (is_maze_file(name.c_str()) && maze_file.open(name.c_str())) {
+			const auto saved = maze_file.binarization();
+			maze_file.read_grid(0, 0, maze_file.width(), maze_file.height(), m_grid);
+			m_grid_threshold = saved.method == binarize_method_t::otsu ? otsu_threshold(histogram) : saved.threshold;
+			m_grid_method = saved.method;
+			m_grid_radius = saved.method == binarize_method_t::bradley || saved.method == binarize_method_t::sauvola ? saved.radius : -1;
+			m_grid_cleanup = saved.cleanup;
+		}
+		return true;
+	}
+
+	//takes a luminance plane that didn't come from a file, like a rectified photo
+	void assign(luminance_image_t plane) {
+		luminance = std::move(plane);
+		histogram = {};
+		std::mutex merge;
+		parallel_for(luminance.height, [&](const size_t first_row, const size_t last_row) {
+			std::array<uint64_t, 256> band = {};
+			for (auto i = first_row * luminance.width; i < last_row * luminance.width; ++i) ++band[luminance.pixels[i]];
+			std::lock_guard<std::mutex> lock(merge);
+			for (size_t value = 0; value < 256; ++value) histogram[value] += band[value];
+		});
+		m_grid = {};
+		m_grid_threshold = INT_MIN;
+		m_grid_radius = -1;
+	}
+
+	double open_fraction(const int threshold) const { //share of pixels a threshold would open, straight from the histogram
+		uint64_t open = 0;
+		for (int value = std::max(threshold + 1, 0); value < 256; ++value) open += histogram[value];
+		return luminance.pixels.empty() ? 0 : double(open) / luminance.pixels.size();
+	}
+
+	//threshold is only used by the global method, radius only by the local ones (0 picks one from the image size).
+	//cleanup runs on the binarized grid before it is handed out
+	const bit_grid_t& grid(const int threshold, const binarize_method_t method = binarize_method_t::global, const int radius = 0, const cleanup_t& cleanup = {}) {
+		const auto key_threshold = method == binarize_method_t::otsu ? otsu_threshold(histogram) : threshold;
+		const auto key_radius = method == binarize_method_t::bradley || method == binarize_method_t::sauvola ? radius : -1;
+		if (key_threshold == m_grid_threshold && method == m_grid_method && key_radius == m_grid_radius && cleanup == m_grid_cleanup) return m_grid;
+
+		const auto& pixels = luminance.pixels;
+		if (method == binarize_method_t::bradley) m_grid = bradley_binarize(pixels, luminance.width, luminance.height, radius);
+		else if (method == binarize_method_t::sauvola) m_grid = sauvola_binarize(pixels, luminance.width, luminance.height, radius);
+		else {
+			const auto& kernels = image_kernels();
+			m_grid = bit_grid_t(luminance.width, luminance.height);
+			parallel_for(luminance.height, [&](const size_t first_row, const size_t last_row) {
+				for (auto y = first_row; y < last_row; ++y)
+					kernels.binarize_plane(&pixels[y * luminance.width], m_grid.row(y), luminance.width, key_threshold);
+			});
+		}
+		if (cleanup.op != morph_op_t::none) m_grid = cleanup.apply(m_grid);
+		m_grid_threshold = key_threshold;
+		m_grid_method = method;
+		m_grid_radius = key_radius;
+		m_grid_cleanup = cleanup;
+		return m_grid;
+	}
+
+	//the cached luminance as grey pixels, for showing anything that has no colours of its own
+	std::vector<rgba_t> preview(unsigned& width, unsigned& height) const {
+		std::vector<rgba_t> pixels(luminance.pixels.size());
+		parallel_for(pixels.size(), [&](const size_t first, const size_t last) {
+			for (auto i = first; i < last; ++i) pixels[i] = { luminance.pixels[i], luminance.pixels[i], luminance.pixels[i], 0xFF };
+		});
+		width = luminance.width;
+		height = luminance.height;
+		return pixels;
+	}
+
+private:
+	bit_grid_t m_grid;
+	int m_grid_threshold = INT_MIN, m_grid_radius = -1;
+	binarize_method_t m_grid_method = binarize_method_t::global;
+	cleanup_t m_grid_cleanup;
+};
+
+//everything choosing a file decodes, done together so it can run off the gl thread
+struct loaded_image_t {
+	source_image_t source;
+	std::vector<rgba_t> preview;
+	unsigned width = 0, height = 0;
+	image_pyramid_t pyramid; //of the preview, for the view
+	bool ok = false;
+};
+
+inline loaded_image_t load_image(const std::string& name) {
+	loaded_image_t out;
+	if (!out.source.load(name, &out.preview)) return out; //a colour file decodes once, into the preview and the luminance
+	if (out.preview.empty()) out.preview = out.source.preview(out.width, out.height);
+	out.width = out.source.luminance.width;
+	out.height = out.source.luminance.height;
+	out.ok = !out.preview.empty();
+	if (out.ok) out.pyramid.build(out.preview.data(), out.width, out.height, tiled_view_t::tile);
+	return out;
+}
@@ -1,5 +1,7 @@
 #pragma once
 #include "includes.hpp"
+#include "image_kernels.hpp"
+#include "tiled_view.hpp"
 
 constexpr rgba_t black = { 0x00, 0x00, 0x00, 0xFF };
 constexpr rgba_t white = { 0xFF, 0xFF, 0xFF, 0xFF };
@@ -7,135 +9,125 @@ constexpr rgba_t gray  = { 0x80, 0x80, 0x80, 0xFF };
 constexpr rgba_t red   = { 0xFF, 0x00, 0x00, 0xFF };
 constexpr rgba_t green = { 0x00, 0xFF, 0x00, 0xFF };
 
-class image_manip { //class for manipulating opengl textures
-	GLuint *m_texture_id = nullptr;
-	uint8_t* m_texture_buffer = nullptr;
+class image_manip { //the image being shown: edited here on the cpu, and drawn through a tiled_view_t
 	unsigned* m_width = nullptr, *m_height = nullptr;
-	const static int m_channels = 4;
+
+	std::vector<rgba_t> m_pixels; //the image itself; the view only keeps smaller levels
+	tiled_view_t m_view;
+
+	//what the current edit touched, as m_tile x m_tile squares; end_edit hands only those to the view
+	const static unsigned m_tile = 128;
+	std::vector<uint8_t> m_dirty;
+	unsigned m_tiles_x = 0, m_tiles_y = 0;
+	bool m_edited = false; //drawn on since the last replace
 	
-	void lock_texture() {
-		m_texture_buffer = new uint8_t[*m_width * *m_height * m_channels]();
-		GLuint fbo;
-		glGenFramebuffers(1, &fbo); 
-		glBindFramebuffer(GL_FRAMEBUFFER, fbo);
-		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, *m_texture_id, 0);
-		
-		glReadPixels(0, 0, *m_width, *m_height, GL_RGBA, GL_UNSIGNED_BYTE, m_texture_buffer);
-		
-		glBindFramebuffer(GL_FRAMEBUFFER, 0);
-		glDeleteFramebuffers(1, &fbo);
+	void begin_edit() {
+		m_view.cancel_uploads(); //they read the pixels about to change
+		m_dirty.assign(size_t(m_tiles_x) * m_tiles_y, 0);
 	}
 
-	void unlock_texture() {
-		glBindTexture(GL_TEXTURE_2D, *m_texture_id);
-		glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, *m_width, *m_height, GL_RGBA, GL_UNSIGNED_BYTE, m_texture_buffer);
-		glBindTexture(GL_TEXTURE_2D, 0);
-		delete[] m_texture_buffer;
+	//invalidates the dirty tiles in the view, each run of them along a tile row as one rectangle, grown downwards
+	//while the rows below have the same run dirty. a whole-image edit is a single rectangle, a region only the tiles under it
+	void end_edit() {
+		for (unsigned ty = 0; ty < m_tiles_y; ++ty) {
+			const auto row = &m_dirty[size_t(ty) * m_tiles_x];
+			for (unsigned tx = 0; tx < m_tiles_x; ++tx) {
+				if (!row[tx]) continue;
+				auto tx_end = tx;
+				while (tx_end < m_tiles_x && row[tx_end]) ++tx_end;
+				auto ty_end = ty + 1;
+				while (ty_end < m_tiles_y) {
+					const auto below = &m_dirty[size_t(ty_end) * m_tiles_x];
+					if (!std::all_of(below + tx, below + tx_end, [](const uint8_t d) { return d != 0; })) break;
+					if ((tx > 0 && below[tx - 1]) || (tx_end < m_tiles_x && below[tx_end])) break; //part of a wider run
+					std::fill(below + tx, below + tx_end, uint8_t(0));
+					++ty_end;
+				}
+				m_view.invalidate(tx * m_tile, ty * m_tile, std::min(tx_end * m_tile, *m_width), std::min(ty_end * m_tile, *m_height));
+				tx = tx_end - 1;
+			}
+		}
 	}
 
-	rgba_t* get_pixel_ptr(const point_t point) {
-		return (rgba_t*)((uintptr_t)m_texture_buffer + (point.y * (*m_width * m_channels)) + point.x * m_channels);
+	//marks the pixels in [x0, x1) x [y0, y1) as changed
+	void mark_dirty(const unsigned x0, const unsigned y0, const unsigned x1, const unsigned y1) {
+		if (x0 >= x1 || y0 >= y1) return;
+		m_edited = true;
+		for (auto ty = y0 / m_tile; ty <= (y1 - 1) / m_tile; ++ty)
+			std::fill_n(&m_dirty[size_t(ty) * m_tiles_x + x0 / m_tile], (x1 - 1) / m_tile - x0 / m_tile + 1, uint8_t(1));
 	}
 
-	rgba_t get_pixel(const point_t point) {
-		return *get_pixel_ptr(point);
+	void mark_all_dirty() {
+		m_edited = true;
+		std::fill(m_dirty.begin(), m_dirty.end(), uint8_t(1));
 	}
 
-	void set_pixel(const point_t point, const rgba_t color) {
-		*get_pixel_ptr(point) = color;
+	rgba_t* pixel_ptr(const unsigned x, const unsigned y) {
+		return &m_pixels[size_t(y) * *m_width + x];
 	}
 
-	uint8_t get_luminance(const point_t point) {
-		const auto cols = get_pixel(point);
-		return uint8_t(0.2126f * cols.r + 0.7152f * cols.g + 0.0722f * cols.b); //relative luminance = 0.2126R + 0.7152G + 0.0722B
-	}
-	
 public:
-	image_manip(GLuint *ptexture_id, unsigned* width, unsigned* height) : m_texture_id(ptexture_id), m_width(width), m_height(height) { }
-
-	void binarize_texture(const int threshold = 200) {
-		lock_texture();
-		for (int x = 0; x < *m_width; x++)
-			for (int y = 0; y < *m_height; y++)
-				get_luminance({ x, y }) > threshold ? set_pixel({ x, y }, white) : set_pixel({ x, y }, black);
-		unlock_texture();
+	image_manip(unsigned* width, unsigned* height) : m_width(width), m_height(height) { }
+
+	//shows pixels instead, a width x height image. a pyramid built for them elsewhere can be handed over
+	void replace(std::vector<rgba_t> pixels, const unsigned width, const unsigned height, image_pyramid_t pyramid = {}) {
+		m_view.cancel_uploads();
+		*m_width = width;
+		*m_height = height;
+		m_pixels = std::move(pixels);
+		m_tiles_x = (width + m_tile - 1) / m_tile;
+		m_tiles_y = (height + m_tile - 1) / m_tile;
+		m_edited = false;
+		m_view.set_image(m_pixels.data(), width, height, std::move(pyramid));
 	}
 
-	void darken_background() {
-		lock_texture();
-		for (int y = 0; y < *m_height; y++)
-			for (int x = 0; x < *m_width; x++)
-				if (get_pixel({ x, y }) == white)
-					set_pixel({ x, y }, gray);
-		unlock_texture();
+	//whether anything was drawn over the pixels given to replace
+	bool edited() const { return m_edited; }
+
+	tiled_view_t& view() { return m_view; }
+
+	void draw_grid(const bit_grid_t& grid) { //shows open cells white on black
+		const auto& kernels = image_kernels();
+		begin_edit();
+		parallel_for(*m_height, [&](const size_t first_row, const size_t last_row) {
+			for (auto y = first_row; y < last_row; y++)
+				kernels.expand(grid.row(y), pixel_ptr(0, y), *m_width, white, black);
+		});
+		mark_all_dirty();
+		end_edit();
 	}
 
-	auto get_texture_as_bool_vector() {
-		lock_texture();
-		std::vector<bool> out;
-		for (int y = 0; y < *m_height; y++)
-			for (int x = 0; x < *m_width; x++)
-				out.push_back(get_pixel({ x, y }) == white);
-		return out;
-		unlock_texture();
+	void darken_background() {
+		const auto& kernels = image_kernels();
+		begin_edit();
+		parallel_for(*m_height, [&](const size_t first_row, const size_t last_row) {
+			for (auto y = first_row; y < last_row; y++)
+				kernels.replace(pixel_ptr(0, y), *m_width, white, gray);
+		});
+		mark_all_dirty();
+		end_edit();
 	}
 
-	void draw_points(const std::vector<std::tuple<int, int, rgba_t>>& pixels) {
-		lock_texture();
-		for (const auto& pixel : pixels) {
-			if (std::get<0>(pixel) < 0 || std::get<0>(pixel) >= *m_width) continue;
-			if (std::get<1>(pixel) < 0 || std::get<1>(pixel) >= *m_height) continue;
-			set_pixel({ std::get<0>(pixel), std::get<1>(pixel) }, std::get<2>(pixel));
-		}
-		unlock_texture();
+	void draw_image(const std::vector<rgba_t>& pixels) { //replaces the whole image, pixels must be width * height
+		begin_edit();
+		parallel_for(*m_height, [&](const size_t first_row, const size_t last_row) {
+			memcpy(pixel_ptr(0, first_row), &pixels[first_row * *m_width], (last_row - first_row) * *m_width * sizeof(rgba_t));
+		});
+		mark_all_dirty();
+		end_edit();
 	}
 
-	void draw_markers(const point_t start, const point_t end, int marker_size) {
-		static std::vector<std::tuple<int, int, rgba_t>> storage;
-		static auto cached_texture = *m_texture_id;
-		if (*m_texture_id != cached_texture) {
-			storage.clear();
-			cached_texture = *m_texture_id;
-		}
-		lock_texture();
-		for (const auto& pix : storage) {
-			if (std::get<0>(pix) > *m_width - 1 || std::get<1>(pix) > *m_height - 1)
-				continue;
-			set_pixel({ std::get<0>(pix), std::get<1>(pix) }, std::get<2>(pix)); //put back the overwritten pixels
-		}
-		storage.clear();
-		for (int y = 0; y < marker_size; y++) {
-			for (int x = 0; x < marker_size; x++) {
-				if (start.x + x > *m_width - 1 || start.y + y > *m_height - 1) continue;
-				storage.push_back({ start.x + x, start.y + y, get_pixel({start.x + x, start.y + y}) }); //save pixels overwritten by start marker
-			}
-		}
-		for (int y = 0; y < marker_size; y++) {
-			for (int x = 0; x < marker_size; x++) {
-				if (end.x + x > * m_width - 1 || end.y + y > * m_height - 1) continue;
-				storage.push_back({ end.x + x, end.y + y, get_pixel({end.x + x, end.y + y}) }); //save pixels overwritten by end marker
-			}
-		}
-		for (int y = 0; y < marker_size; y++) {
-			for (int x = 0; x < marker_size; x++) {
-				if (start.x + x > *m_width - 1 || start.y + y > *m_height - 1) continue;
-				set_pixel({ start.x + x, start.y + y }, red); //draw start marker
-			}
-		}
-		for (int y = 0; y < marker_size; y++) {
-			for (int x = 0; x < marker_size; x++) {
-				if (end.x + x > * m_width - 1 || end.y + y > * m_height - 1) continue;
-				set_pixel({ end.x + x, end.y + y }, green); //draw end marker
-			}
-		}
-		unlock_texture();
+	void draw_region(const std::vector<rgba_t>& pixels, const unsigned x, const unsigned y, const unsigned w, const unsigned h) { //pixels must be w * h, and the rectangle inside the image
+		begin_edit();
+		parallel_for(h, [&](const size_t first_row, const size_t last_row) {
+			for (auto row = first_row; row < last_row; row++)
+				memcpy(pixel_ptr(x, y + row), &pixels[row * w], w * sizeof(rgba_t));
+		});
+		mark_dirty(x, y, x + w, y + h);
+		end_edit();
 	}
 
-	std::vector<rgba_t> get_image_data() {
-		lock_texture();
-		std::vector<rgba_t> vec(*m_width * *m_height);
-		memcpy(vec.data(), m_texture_buffer, *m_width * *m_height * m_channels);
-		unlock_texture();
-		return vec;
+	std::vector<rgba_t> get_image_data() const {
+		return m_pixels;
 	}
 };
\ No newline at end of file
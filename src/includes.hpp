@@ -16,7 +16,14 @@
 
 #include "../tinyfiledialogs/tinyfiledialogs.h"
 
+#include "thread_pool.hpp"
+
 #include <algorithm>
+#include <cstring>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <numeric>
 #include <string>
 #include <thread>
 #include <vector>
@@ -47,16 +54,87 @@ struct point_t {
 	}
 };
 
+inline int popcount64(const uint64_t v) {
+#ifdef _MSC_VER
+	return int(__popcnt64(v));
+#else
+	return __builtin_popcountll(v);
+#endif
+}
+
+inline int ctz64(const uint64_t v) { //index of the lowest set bit, v must not be 0
+#ifdef _MSC_VER
+	unsigned long index;
+	_BitScanForward64(&index, v);
+	return int(index);
+#else
+	return __builtin_ctzll(v);
+#endif
+}
+
+struct bit_grid_t { //one bit per pixel, set = open. rows start on a word boundary and their padding bits stay clear
+	unsigned width = 0, height = 0;
+	size_t stride = 0; //words per row
+	std::vector<uint64_t> words;
+
+	bit_grid_t() = default;
+	bit_grid_t(const unsigned w, const unsigned h) : width(w), height(h), stride((size_t(w) + 63) / 64), words(stride * h) { }
+
+	bool at(const size_t x, const size_t y) const { return words[y * stride + x / 64] >> (x % 64) & 1; }
+	bool operator[](const point_t p) const { return at(p.x, p.y); }
+
+	void set(const point_t p, const bool open) {
+		auto& word = words[p.y * stride + p.x / 64];
+		const auto bit = uint64_t(1) << (p.x % 64);
+		word = open ? word | bit : word & ~bit;
+	}
+
+	uint64_t* row(const size_t y) { return words.data() + y * stride; }
+	const uint64_t* row(const size_t y) const { return words.data() + y * stride; }
+
+	size_t count() const { //number of open cells
+		size_t out = 0;
+		for (const auto word : words) out += popcount64(word);
+		return out;
+	}
+
+	//the w x h rectangle at (x, y), which must lie inside the grid, as a grid of its own
+	bit_grid_t crop(const unsigned x, const unsigned y, const unsigned w, const unsigned h) const {
+		bit_grid_t out(w, h);
+		const auto shift = x % 64, first_word = x / 64;
+		const auto tail = w % 64 ? (uint64_t(1) << (w % 64)) - 1 : ~uint64_t(0);
+		parallel_for(h, [&](const size_t first_row, const size_t last_row) {
+			for (auto r = first_row; r < last_row; ++r) {
+				const auto in = row(y + r) + first_word;
+				auto dest = out.row(r);
+				for (size_t word = 0; word < out.stride; ++word) {
+					const auto high = shift && first_word + word + 1 < stride ? in[word + 1] << (64 - shift) : 0;
+					dest[word] = in[word] >> shift | high;
+				}
+				dest[out.stride - 1] &= tail;
+			}
+		});
+		return out;
+	}
+};
+
 struct maze_t {
 	unsigned width, height;
 	point_t start, end;
-	std::vector<bool> grid;
+	bit_grid_t grid;
+	//when not empty these replace start/end, and one search finds the closest pair. a set that was asked for but came
+	//out empty (no border exits, say) has to be caught before solving, or the search quietly uses start/end
+	std::vector<point_t> starts, ends;
+
+	std::vector<point_t> sources() const { return starts.empty() ? std::vector<point_t>{ start } : starts; }
+	std::vector<point_t> goals() const { return ends.empty() ? std::vector<point_t>{ end } : ends; }
 };
 
 struct ret_t {
 	bool solved;
 	std::vector<unsigned> cost_map;
 	std::vector<point_t> path;
+	point_t from, to; //the start and end the path actually joins
 };
 
 struct rgba_t {
@@ -68,29 +146,46 @@ struct rgba_t {
 
 struct solution_interface { virtual ret_t solve(const maze_t& maze) = 0; };
 
+//every open cell on the image border, minus the openings the sources sit in (a start on the border is usually
+//an entrance, and its own opening is not an exit)
+std::vector<point_t> open_border_cells(const maze_t& maze) {
+	std::vector<point_t> ring; //the border walked clockwise from the top left corner
+	if (maze.width == 1 || maze.height == 1) {
+		for (int y = 0; y < (int)maze.height; ++y)
+			for (int x = 0; x < (int)maze.width; ++x)
+				ring.push_back({ x, y });
+	}
+	else {
+		const int right = maze.width - 1, bottom = maze.height - 1;
+		for (int x = 0; x < right; ++x) ring.push_back({ x, 0 });
+		for (int y = 0; y < bottom; ++y) ring.push_back({ right, y });
+		for (int x = right; x > 0; --x) ring.push_back({ x, bottom });
+		for (int y = bottom; y > 0; --y) ring.push_back({ 0, y });
+	}
+
+	auto open = [&maze](const point_t& p) { return maze.grid[p]; };
+	const auto wall = std::find_if(ring.begin(), ring.end(), [&](const point_t& p) { return !open(p); });
+	std::rotate(ring.begin(), wall == ring.end() ? ring.begin() : wall, ring.end()); //so no opening wraps around the end
+
+	const auto sources = maze.sources();
+	std::vector<point_t> out;
+	for (size_t first = 0; first < ring.size();) {
+		if (!open(ring[first])) { ++first; continue; }
+		auto last = first;
+		auto entrance = false;
+		while (last < ring.size() && open(ring[last])) {
+			entrance |= std::find(sources.begin(), sources.end(), ring[last]) != sources.end();
+			++last;
+		}
+		if (!entrance) out.insert(out.end(), ring.begin() + first, ring.begin() + last);
+		first = last;
+	}
+	return out;
+}
+
 std::string get_file_name() {
-	const char* const file_types[] = { "*.bmp", "*.dds", "*.dib", "*.hdr", "*.jpg", "*.pfm", "*.png", "*.ppm", "*.tga" };
+	const char* const file_types[] = { "*.bmp", "*.dds", "*.dib", "*.hdr", "*.jpg", "*.maze", "*.pbm", "*.pfm", "*.pgm", "*.png", "*.ppm", "*.tga" };
 	const auto ret = tinyfd_openFileDialog("", "", sizeof(file_types) / sizeof(file_types[0]), file_types, "images", 0);
 	return ret ? std::string(ret) : "";
 }
 
-bool load_texture_from_file(const char* filename, GLuint* out_texture, unsigned* out_width, unsigned* out_height) {
-	GLuint image_texture;
-	glGenTextures(1, &image_texture);
-	glBindTexture(GL_TEXTURE_2D, image_texture);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-	glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
-
-	int image_width = 0, image_height = 0;
-	unsigned char* image_data = stbi_load(filename, &image_width, &image_height, NULL, 4);
-	if (image_data == NULL) return false;
-
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, image_width, image_height, 0, GL_RGBA, GL_UNSIGNED_BYTE, image_data);
-	stbi_image_free(image_data);
-
-	*out_texture = image_texture;
-	*out_width = image_width;
-	*out_height = image_height;
-	return true;
-}
@@ -0,0 +1,202 @@
+#pragma once
+#include "includes.hpp"
+
+//most drawn mazes sit on a regular lattice: wall lines `wall` pixels thick every `pitch` pixels, with corridors of
+//`corridor` = pitch - wall pixels between them. found from run lengths, the lattice cuts each axis into alternating
+//wall and corridor segments; every (segment x, segment y) block becomes one logical cell, open when most of its pixels
+//are, and searching that grid costs about (pitch / 2)^2 times less than searching pixels
+struct lattice_axis_t {
+	bool regular = false;
+	unsigned pitch = 0, wall = 0, corridor = 0, phase = 0; //phase: where a wall line starts, mod pitch
+	std::vector<unsigned> begin; //first pixel of each segment, plus one past the end
+	std::vector<unsigned> segment_of; //segment of each pixel
+
+	size_t segments() const { return begin.empty() ? 0 : begin.size() - 1; }
+	unsigned center(const size_t segment) const { return (begin[segment] + begin[segment + 1] - 1) / 2; }
+
+	//run lengths along up to max_lines evenly spaced lines. the first and last run of each line are cut off by the
+	//image edge, so they are left out
+	template <typename F>
+	static lattice_axis_t detect(const unsigned length, const unsigned lines, F&& open) {
+		lattice_axis_t out;
+		constexpr unsigned max_lines = 512, max_run = 1024;
+		std::vector<size_t> open_runs(max_run + 1, 0), wall_runs(max_run + 1, 0);
+		std::vector<std::pair<unsigned, unsigned>> walls; //(start, length) of every wall run, for the phase
+		const auto step = std::max(1u, lines / max_lines);
+		for (unsigned line = step / 2; line < lines; line += step) {
+			unsigned run_start = 0;
+			auto first = true;
+			for (unsigned i = 1; i <= length; ++i) {
+				if (i < length && open(line, i) == open(line, run_start)) continue;
+				if (!first && i < length) {
+					const auto run = std::min(i - run_start, max_run);
+					if (open(line, run_start)) ++open_runs[run];
+					else {
+						++wall_runs[run];
+						walls.push_back({ run_start, i - run_start });
+					}
+				}
+				first = false;
+				run_start = i;
+			}
+		}
+
+		const auto mode = [](const std::vector<size_t>& histogram) {
+			return unsigned(std::max_element(histogram.begin() + 1, histogram.end()) - histogram.begin());
+		};
+		const auto total = [](const std::vector<size_t>& histogram) { return std::accumulate(histogram.begin(), histogram.end(), size_t(0)); };
+		if (total(open_runs) < 16 || total(wall_runs) < 16) return out;
+		out.wall = mode(wall_runs);
+		out.corridor = mode(open_runs);
+		out.pitch = out.wall + out.corridor;
+		if (out.corridor < 2 || out.pitch < 4) return out; //already about one pixel per cell, nothing to gain
+
+		//a corridor running through k cells is k * pitch - wall long and a wall running past k cells k * pitch + wall,
+		//so on a lattice nearly every run has the right length mod pitch
+		const auto tolerance = std::max(1u, out.pitch / 8);
+		auto fits = [&](const std::vector<size_t>& histogram, const unsigned expected) {
+			size_t matching = 0;
+			for (unsigned run = 1; run < max_run; ++run) {
+				const auto off = (run + out.pitch - expected % out.pitch) % out.pitch;
+				if (std::min(off, out.pitch - off) <= tolerance) matching += histogram[run];
+			}
+			return matching * 4 >= total(histogram) * 3;
+		};
+		if (!fits(open_runs, out.corridor) || !fits(wall_runs, out.wall)) return out;
+
+		std::vector<size_t> phases(out.pitch, 0);
+		for (const auto& wall : walls)
+			if (wall.second % out.pitch <= out.wall + tolerance && wall.second % out.pitch + tolerance >= out.wall) ++phases[wall.first % out.pitch];
+		out.phase = unsigned(std::max_element(phases.begin(), phases.end()) - phases.begin());
+
+		//alternating wall and corridor segments, starting from the wall line at or before pixel 0
+		for (auto position = (long long)out.phase - out.pitch; position < length; position += out.pitch) {
+			for (const auto edge : { position, position + out.wall })
+				if (edge > 0 && edge < length) out.begin.push_back(unsigned(edge));
+		}
+		out.begin.insert(out.begin.begin(), 0);
+		out.begin.push_back(length);
+		out.segment_of.resize(length);
+		for (size_t segment = 0; segment + 1 < out.begin.size(); ++segment)
+			std::fill(out.segment_of.begin() + out.begin[segment], out.segment_of.begin() + out.begin[segment + 1], unsigned(segment));
+		out.regular = true;
+		return out;
+	}
+};
+
+struct lattice_t {
+	lattice_axis_t x, y;
+	bit_grid_t grid; //one bit per logical cell
+
+	bool regular() const { return x.regular && y.regular; }
+	point_t to_logical(const point_t p) const { return { int(x.segment_of[p.x]), int(y.segment_of[p.y]) }; }
+	point_t to_pixel(const point_t p) const { return { int(x.center(p.x)), int(y.center(p.y)) }; }
+
+	static lattice_t detect(const bit_grid_t& pixels) {
+		lattice_t out;
+		out.x = lattice_axis_t::detect(pixels.width, pixels.height, [&](const unsigned row, const unsigned i) { return pixels.at(i, row); });
+		out.y = lattice_axis_t::detect(pixels.height, pixels.width, [&](const unsigned column, const unsigned i) { return pixels.at(column, i); });
+		if (!out.regular()) return out;
+
+		//a block is open when at least half its pixels are, which also rides over jpeg specks
+		const auto columns = out.x.segments(), rows = out.y.segments();
+		out.grid = bit_grid_t(unsigned(columns), unsigned(rows));
+		parallel_for(rows, [&](const size_t first_row, const size_t last_row) {
+			std::vector<size_t> open(columns);
+			for (auto row = first_row; row < last_row; ++row) {
+				std::fill(open.begin(), open.end(), 0);
+				for (auto py = out.y.begin[row]; py < out.y.begin[row + 1]; ++py)
+					for (size_t column = 0; column < columns; ++column)
+						open[column] += count_open(pixels, py, out.x.begin[column], out.x.begin[column + 1]);
+				const size_t block_rows = out.y.begin[row + 1] - out.y.begin[row];
+				for (size_t column = 0; column < columns; ++column)
+					if (open[column] * 2 >= block_rows * (out.x.begin[column + 1] - out.x.begin[column]))
+						out.grid.row(row)[column / 64] |= uint64_t(1) << (column % 64);
+			}
+		});
+		return out;
+	}
+
+private:
+	static size_t count_open(const bit_grid_t& pixels, const size_t y, const size_t first, const size_t last) { //pixels [first, last) of row y
+		const auto row = pixels.row(y);
+		size_t out = 0;
+		for (auto word = first / 64; word * 64 < last; ++word) {
+			auto bits = row[word];
+			if (word == first / 64) bits &= ~uint64_t(0) << (first % 64);
+			if ((word + 1) * 64 > last) bits &= (uint64_t(1) << (last % 64)) - 1;
+			out += popcount64(bits);
+		}
+		return out;
+	}
+};
+
+//solves on the logical grid with another solver, then draws the path back through the block centres. mazes with no
+//regular lattice, or endpoints that fall on a logical wall, go to the other solver at pixel resolution unchanged
+struct lattice_solver : solution_interface {
+	solution_interface* inner = nullptr;
+	lattice_t lattice; //of the last maze solved, for showing what was detected
+	bool used_lattice = false;
+
+	ret_t solve(const maze_t& maze) {
+		lattice = lattice_t::detect(maze.grid);
+		used_lattice = false;
+		if (!lattice.regular()) return inner->solve(maze);
+
+		maze_t logical = { lattice.grid.width, lattice.grid.height, lattice.to_logical(maze.start), lattice.to_logical(maze.end), lattice.grid };
+		auto map_cells = [&](const std::vector<point_t>& pixels, std::vector<point_t>& out) { //returns how many land on walls
+			std::vector<bool> seen(size_t(logical.width) * logical.height, false);
+			size_t on_walls = 0;
+			for (const auto& p : pixels) {
+				const auto l = lattice.to_logical(p);
+				if (!logical.grid[l]) ++on_walls;
+				else if (!seen[size_t(l.y) * logical.width + l.x]) {
+					seen[size_t(l.y) * logical.width + l.x] = true;
+					out.push_back(l);
+				}
+			}
+			return on_walls;
+		};
+		if (!maze.ends.empty()) map_cells(maze.ends, logical.ends); //border exits on logical walls just drop out
+		const auto start_open = maze.starts.empty() ? logical.grid[logical.start] : map_cells(maze.starts, logical.starts) == 0;
+		const auto end_open = maze.ends.empty() ? logical.grid[logical.end] : !logical.ends.empty();
+		if (!start_open || !end_open) return inner->solve(maze);
+
+		const auto found = inner->solve(logical);
+		used_lattice = true;
+		ret_t out = { found.solved };
+		auto original = [&](const std::vector<point_t>& pixels, const point_t single, const point_t cell) { //the endpoint given for that cell
+			if (pixels.empty()) return single;
+			for (const auto& p : pixels)
+				if (lattice.to_logical(p) == cell) return p;
+			return lattice.to_pixel(cell);
+		};
+		out.from = original(maze.starts, maze.start, found.from);
+		out.to = original(maze.ends, maze.end, found.to);
+
+		out.cost_map.assign(size_t(maze.width) * maze.height, UINT_MAX);
+		parallel_for(maze.height, [&](const size_t first_row, const size_t last_row) {
+			for (auto py = first_row; py < last_row; ++py)
+				for (size_t px = 0; px < maze.width; ++px)
+					if (maze.grid.at(px, py)) out.cost_map[py * maze.width + px] = found.cost_map[size_t(lattice.y.segment_of[py]) * logical.width + lattice.x.segment_of[px]];
+		});
+
+		//neighbouring logical cells share a row or a column, so their centres join with a straight run of pixels. the
+		//endpoints join their cells' centres across then down, staying inside the cells' open blocks, and a step back
+		//onto the pixel before undoes the last one instead, so the path never doubles back over itself
+		auto walk_to = [&](const point_t to) {
+			auto at = out.path.back();
+			while (!(at == to)) {
+				if (at.x != to.x) at.x += (to.x > at.x) - (to.x < at.x);
+				else at.y += (to.y > at.y) - (to.y < at.y);
+				if (out.path.size() > 1 && out.path[out.path.size() - 2] == at) out.path.pop_back();
+				else out.path.push_back(at);
+			}
+		};
+		if (found.path.empty()) return out;
+		out.path.push_back(out.from);
+		for (const auto& cell : found.path) walk_to(lattice.to_pixel(cell));
+		walk_to(out.to);
+		return out;
+	}
+};
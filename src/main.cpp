@@ -1,10 +1,24 @@
 #include "includes.hpp"
 #include "image_manip.hpp"
+#include "image_loader.hpp"
+#include "components.hpp"
+#include "threshold_sweep.hpp"
+#include "thresholding.hpp"
+#include "morphology.hpp"
+#include "lattice.hpp"
+#include "endpoints.hpp"
+#include "roi.hpp"
+#include "rectify.hpp"
+#include "overlay.hpp"
+#include "cost_map.hpp"
+#include "cli.hpp"
 
 #include "algos/dijkstra.hpp"
 #include "algos/a_star.hpp"
 #include "algos/breadth_first.hpp"
 #include "algos/depth_first.hpp"
+#include "algos/skeleton.hpp"
+#include "algos/distance_field.hpp"
 
 #ifdef _WIN32
 #pragma comment(lib, "opengl32.lib")
@@ -12,8 +26,16 @@
 #pragma comment(lib, "windows-deps/GLFW/lib/glfw3.lib")
 #pragma comment(linker, "/subsystem:windows")
 int WinMain() {
+	if (__argc > 1) { //a windows subsystem exe has no console of its own, borrow the one it was started from
+		if (AttachConsole(ATTACH_PARENT_PROCESS)) {
+			freopen("CONOUT$", "w", stdout);
+			freopen("CONOUT$", "w", stderr);
+		}
+		return run_cli(__argc, __argv);
+	}
 #else
-int main() {
+int main(int argc, char** argv) {
+	if (argc > 1) return run_cli(argc, argv);
 #endif
 	glfwInit();
 
@@ -41,23 +63,70 @@ int main() {
 	bool path_value = false;
 	float path_cols[3] = { 0.f, 1.f, 0.f };
 	bool cost_map = false;
+	int cost_scale = 0; //a cost_scale_t
+	bool cost_heat = false;
+	bool show_components = false;
+	int threshold = 200;
+	int binarize_method = 0; //a binarize_method_t
+	int window_radius = 0; //for the local methods, 0 picks one from the image size
+	cleanup_t cleanup;
+	long long loops = 0; //independent cycles in the open cells, found with the components
 	point_t start = { 0, 0 }, end = { 0, 0 };
-	bool show_whole_image = false;
+	bool border_exit = false;
+	bool fit_view = false, actual_size = false; //asked for by the buttons, done where the view's size is known
 	int marker_size = 10;
+	roi_t roi; //solves only look inside it, empty for the whole image
+	bool drawing_roi = false; //dragging over the image draws roi instead of scrolling
+	point_t roi_anchor = { -1, -1 }; //where the drag started, -1 when not dragging
+	bool rectify = false; //solve on the photo straightened between the corners, and draw the path back onto it
+	corners_t corners = {};
+	int corners_placed = 4; //below 4 while they are being clicked
+	int rectified_size = 2048; //longer side of the straightened maze
+	rectification_t rectification;
+	source_image_t rectified; //the straightened luminance, binarized like the photo
+	bool rectified_stale = true;
 
 	std::string file_name = "";
-	GLuint picture = 0;
 	unsigned pic_width = 0, pic_height = 0;
 	bool pic_chosen = false;
 	bool solved = false;
-	image_manip* img = nullptr;
+	std::unique_ptr<image_manip> img(new image_manip(&pic_width, &pic_height));
+	std::vector<rgba_t> photo; //while rectifying, the photo and its pyramid, put back under each rectified path
+	image_pyramid_t photo_pyramid;
+	std::future<loaded_image_t> loading; //the file being decoded, valid until it's picked up
+	path_overlay_t path_overlay; //drawn over the image while solved
+	std::unique_ptr<cost_overlay_t> cost_overlay(new cost_overlay_t); //same, when the cost map is asked for
+	source_image_t source;
+	components_t components;
+	std::vector<kernel_benchmark_t> benchmarks;
+	bool components_stale = true; //labels belong to one image at one threshold
 
 	int chosen_algo = 0;
 	solution_interface* algo = nullptr;
-	solution_interface* algos[] = { new dijkstra, new a_star, new breadth_first, new depth_first };
+	auto skeleton_algo = new skeleton;
+	solution_interface* algos[] = { new dijkstra, new a_star, new breadth_first, new depth_first, skeleton_algo };
+	bool use_lattice = false;
+	lattice_solver lattice;
+
+	auto current_grid = [&]() -> const bit_grid_t& { return source.grid(threshold, binarize_method_t(binarize_method), window_radius, cleanup); };
+	auto rectified_grid = [&]() -> const bit_grid_t& {
+		if (rectified_stale) {
+			if (!rectify_photo(source.luminance, corners, rectified_size, rectification, rectified)) { //half picked corners
+				corners = image_corners(pic_width, pic_height);
+				rectify_photo(source.luminance, corners, rectified_size, rectification, rectified);
+			}
+			rectified_stale = false;
+			components_stale = true;
+		}
+		return rectified.grid(threshold, binarize_method_t(binarize_method), window_radius, cleanup);
+	};
 
 	while (!glfwWindowShouldClose(window)) {
 		glfwPollEvents();
+		if (!rectify && !photo.empty()) { //only kept while rectifying
+			photo = {};
+			photo_pyramid = {};
+		}
 
 		ImGui_ImplOpenGL3_NewFrame();
 		ImGui_ImplGlfw_NewFrame();
@@ -74,24 +143,71 @@ int main() {
 				ImGui::SetWindowPos(ImVec2(0, 0));
 			}
 
-			if (ImGui::Button("upload maze...")) {
-				file_name = get_file_name();
-				if (file_name == "") {}
-				else if (!pic_chosen) {
-					load_texture_from_file(file_name.c_str(), &picture, &pic_width, &pic_height);
-
-					img = new image_manip(&picture, &pic_width, &pic_height);
-					pic_chosen = true;
-					solved = false;
-				}
+			if (ImGui::Button("upload maze...") && !loading.valid()) {
+				const auto chosen = get_file_name();
+				if (chosen != "") loading = std::async(std::launch::async, load_image, chosen); //decoding a big file takes seconds
+			}
+			if (loading.valid()) {
+				ImGui::SameLine();
+				ImGui::Text("loading...");
+			}
+			if (loading.valid() && loading.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+				auto loaded = loading.get();
+				if (!loaded.ok)
+					tinyfd_messageBox("alert", "could not load image", "info", "info", 1);
 				else {
-					load_texture_from_file(file_name.c_str(), &picture, &pic_width, &pic_height);
+					source = std::move(loaded.source);
+					file_name = source.file_name;
+					photo = {};
+					photo_pyramid = {};
+					img->replace(std::move(loaded.preview), loaded.width, loaded.height, std::move(loaded.pyramid));
+					fit_view = true;
+					binarization_t saved; //a .maze file comes back binarized the way it was saved
+					if (load_saved_binarization(file_name.c_str(), saved)) {
+						threshold = saved.threshold;
+						binarize_method = int(saved.method);
+						window_radius = saved.radius;
+						cleanup = saved.cleanup;
+					}
+					if (binarize_method_t(binarize_method) == binarize_method_t::otsu) threshold = otsu_threshold(source.histogram);
+					start = { 0, 0 };
+					end = { int(pic_width) - 1, int(pic_height) - 1 };
+					if (!load_saved_endpoints(file_name.c_str(), start, end)) propose_endpoints(current_grid(), start, end);
+					roi = {};
+					rectify = false;
+					corners = image_corners(pic_width, pic_height);
+					corners_placed = 4;
+					rectified_stale = true;
+					pic_chosen = true;
+					components_stale = true;
 					solved = false;
 				}
 			}
 
+			if (ImGui::CollapsingHeader("kernel benchmarks")) {
+				ImGui::Text("using %s kernels", image_kernels().name);
+				if (ImGui::Button("run benchmarks")) benchmarks = benchmark_kernels();
+				for (const auto& benchmark : benchmarks)
+					ImGui::Text("%-8s %-10s %9.1f Mpx/s", benchmark.kernels.c_str(), benchmark.kernel.c_str(), benchmark.pixels_per_second / 1e6);
+			}
+
+			if (ImGui::CollapsingHeader("gpu resources")) {
+				auto& resources = gl_resources::shared();
+				const auto& stats = resources.stats();
+				const auto& view = img->view();
+				const auto mb = [](const size_t bytes) { return double(bytes) / (1 << 20); };
+				ImGui::Text("textures:      %5zu in use (%7.1f MB), %4zu spare (%6.1f MB)", stats.textures, mb(stats.texture_bytes), stats.spare_textures, mb(stats.spare_texture_bytes));
+				ImGui::Text("pixel buffers: %5zu in use (%7.1f MB), %4zu spare (%6.1f MB)", stats.buffers, mb(stats.buffer_bytes), stats.spare_buffers, mb(stats.spare_buffer_bytes));
+				ImGui::Text("created %zu, reused %zu, deleted %zu", stats.created, stats.reused, stats.deleted);
+				ImGui::Text("image: %zu tiles (%.1f MB), %.1f MB uploaded through %s buffers", view.resident_tiles(), mb(view.resident_bytes()),
+					mb(view.uploaded_bytes()), view.persistent_buffers() ? "persistent" : "remapped");
+				if (ImGui::Button("free spares")) resources.trim();
+			}
+
 			if (pic_chosen) {
-				ImGui::Checkbox("show entire image", &show_whole_image);
+				fit_view |= ImGui::Button("fit");
+				ImGui::SameLine();
+				actual_size |= ImGui::Button("1:1");
 				ImGui::SameLine();
 				ImGui::Text("size: %dx%d", pic_width, pic_height);
 
@@ -100,12 +216,95 @@ int main() {
 				ImGui::SliderInt("start y    ", &start.y, 0, pic_height - 1);
 				ImGui::SliderInt("end x      ", &end.x, 0, pic_width - 1);
 				ImGui::SliderInt("end y      ", &end.y, 0, pic_height - 1);
+				if (ImGui::Button("find entrances") && !propose_endpoints(current_grid(), start, end))
+					tinyfd_messageBox("alert", "no gaps found in the outer wall", "info", "info", 1);
+				ImGui::SameLine();
+				ImGui::Checkbox("draw roi", &drawing_roi);
+				ImGui::SameLine();
+				if (ImGui::Button("auto crop")) {
+					roi = maze_bounds(current_grid());
+					components_stale = true;
+				}
+				ImGui::SameLine();
+				if (ImGui::Button("clear roi")) {
+					roi = {};
+					components_stale = true;
+				}
+				ImGui::SameLine();
+				if (roi.empty()) ImGui::Text("roi: whole image");
+				else ImGui::Text("roi: %ux%u at %u,%u", roi.width, roi.height, roi.x, roi.y);
+				if (ImGui::Checkbox("rectify photo", &rectify)) components_stale = true;
+				ImGui::SameLine();
+				if (ImGui::Button("find corners")) {
+					if (find_corners(source.luminance, corners)) {
+						rectify = true;
+						rectified_stale = true;
+					}
+					else tinyfd_messageBox("alert", "no maze walls found", "info", "info", 1);
+				}
+				ImGui::SameLine();
+				if (ImGui::Button(corners_placed < 4 ? "click the corners..." : "pick corners")) corners_placed = 0;
+				ImGui::SameLine();
+				ImGui::PushItemWidth(200);
+				if (ImGui::SliderInt("rectified size", &rectified_size, 256, 8192)) rectified_stale = true;
+				ImGui::PopItemWidth();
+				if (rectify && !rectified_stale) {
+					ImGui::SameLine();
+					ImGui::Text("%ux%u", rectification.width, rectification.height);
+				}
+				auto rebinarized = false; //rebinarizes the cached plane, only the labels go stale
+				if (ImGui::Combo("binarize   ", &binarize_method, binarize_method_names, 4)) {
+					if (binarize_method_t(binarize_method) == binarize_method_t::otsu) threshold = otsu_threshold(source.histogram);
+					rebinarized = true;
+				}
+				const auto local = binarize_method_t(binarize_method) == binarize_method_t::bradley || binarize_method_t(binarize_method) == binarize_method_t::sauvola;
+				if (local) rebinarized |= ImGui::SliderInt("window radius", &window_radius, 0, 512, window_radius ? "%d" : "auto");
+				else if (ImGui::SliderInt("threshold  ", &threshold, -1, 255)) {
+					binarize_method = int(binarize_method_t::global); //a hand-picked threshold is no longer otsu's
+					rebinarized = true;
+				}
+				auto cleanup_op = int(cleanup.op), cleanup_element = int(cleanup.element);
+				if (ImGui::Combo("cleanup    ", &cleanup_op, morph_op_names, 4)) rebinarized = true;
+				if (cleanup_op != int(morph_op_t::none)) {
+					rebinarized |= ImGui::Combo("element    ", &cleanup_element, morph_element_names, 3);
+					rebinarized |= ImGui::SliderInt("cleanup radius", &cleanup.radius, 1, 8);
+				}
+				cleanup.op = morph_op_t(cleanup_op);
+				cleanup.element = morph_element_t(cleanup_element);
+				if (rebinarized) {
+					img->draw_grid(current_grid());
+					components_stale = true;
+					solved = false;
+				}
+				float histogram[256];
+				for (int value = 0; value < 256; ++value) histogram[value] = logf(1.f + float(source.histogram[value])); //log so the peaks don't flatten the rest
+				char overlay[32] = {}; //local methods have no single cut to read off the histogram
+				if (!local) snprintf(overlay, sizeof(overlay), "%.1f%% open", source.open_fraction(threshold) * 100.);
+				ImGui::PlotHistogram("luminance  ", histogram, 256, 0, overlay, 0.f, FLT_MAX, ImVec2(0, 60));
+				ImGui::SameLine();
+				ImGui::Text("loops: %lld", loops);
 
 				ImGui::RadioButton("dijkstra", &chosen_algo, 0); ImGui::SameLine();
 				ImGui::RadioButton("a* search", &chosen_algo, 1); ImGui::SameLine();
 				ImGui::RadioButton("breadth first", &chosen_algo, 2); ImGui::SameLine();
-				ImGui::RadioButton("depth first", &chosen_algo, 3);
+				ImGui::RadioButton("depth first", &chosen_algo, 3); ImGui::SameLine();
+				ImGui::RadioButton("skeleton", &chosen_algo, 4);
 				algo = algos[chosen_algo];
+				ImGui::Checkbox("solve on logical cells", &use_lattice);
+				if (use_lattice) {
+					lattice.inner = algo;
+					algo = &lattice;
+				}
+				ImGui::SameLine();
+				ImGui::Checkbox("nearest border exit", &border_exit);
+				if (chosen_algo == 4 && solved)
+					ImGui::Text("skeleton: %zu pixels, %zu nodes, %zu edges", skeleton_algo->lines.count(), skeleton_algo->nodes, skeleton_algo->edges / 2);
+				if (use_lattice && solved) {
+					if (lattice.used_lattice)
+						ImGui::Text("pitch %u x %u (wall %u, corridor %u), %u x %u cells", lattice.lattice.x.pitch, lattice.lattice.y.pitch,
+							lattice.lattice.x.wall, lattice.lattice.x.corridor, lattice.lattice.grid.width, lattice.lattice.grid.height);
+					else ImGui::Text("no regular pitch, solved per pixel");
+				}
 
 				if (!cost_map) {
 					ImGui::Checkbox("path color based on value", &path_value);
@@ -117,36 +316,107 @@ int main() {
 				}
 
 				ImGui::Checkbox("draw cost map?", &cost_map);
+				if (cost_map) {
+					auto recolor = false;
+					ImGui::SameLine();
+					recolor |= ImGui::RadioButton("linear", &cost_scale, int(cost_scale_t::linear));
+					ImGui::SameLine();
+					recolor |= ImGui::RadioButton("log", &cost_scale, int(cost_scale_t::log));
+					ImGui::SameLine();
+					recolor |= ImGui::Checkbox("heat colors", &cost_heat);
+					if (recolor) cost_overlay->render(cost_scale_t(cost_scale), cost_heat ? colormap_t::heat : colormap_t::gray);
+				}
 				ImGui::SameLine();
-				if (ImGui::Button("solve")) {
-					load_texture_from_file(file_name.c_str(), &picture, &pic_width, &pic_height);
-					img->binarize_texture();
-					const auto binary_maze = img->get_texture_as_bool_vector();
-					auto ret = algo->solve({ pic_width, pic_height, start, end, binary_maze });
-					if (ret.solved) {
-						std::vector<std::tuple<int, int, rgba_t>> points;
-						if (cost_map) {
-							std::replace(ret.cost_map.begin(), ret.cost_map.end(), UINT_MAX, 0u);
-							const auto max_distance = *std::max_element(ret.cost_map.begin(), ret.cost_map.end());
-							const auto multiplier = (double)1 / (double)max_distance;
-							for (int i = 0; i < ret.cost_map.size(); ++i) {
-								const auto color = uint8_t((double)255 * (double)multiplier * (double)ret.cost_map[i]);
-								points.push_back({ int(i % pic_width), int(i / pic_width), {color, color, color, 0xFF} });
-							}
+				ImGui::Checkbox("show components", &show_components);
+				ImGui::SameLine();
+				auto solve_now = false;
+				if (ImGui::Button("solve at best threshold")) {
+					const auto best = threshold_sweep{}.find(source.luminance.pixels, pic_width, pic_height, start, end);
+					if (best == threshold_sweep::too_large) tinyfd_messageBox("alert", "image too large to sweep", "info", "info", 1);
+					else {
+						if (best != threshold || binarize_method_t(binarize_method) != binarize_method_t::global) {
+							threshold = best;
+							binarize_method = int(binarize_method_t::global);
+							components_stale = true;
+						}
+						solve_now = true;
+					}
+				}
+				ImGui::SameLine();
+				if (ImGui::Button("solve") || solve_now) {
+					maze_t maze = { pic_width, pic_height, start, end };
+					if (rectify) {
+						if (photo.empty() && !img->edited()) { //taken while it's still what is shown
+							photo = img->get_image_data();
+							photo_pyramid = img->view().pyramid();
+						}
+						else if (photo.empty()) { //already drawn over, so its luminance stands in
+							unsigned photo_width = 0, photo_height = 0;
+							photo = source.preview(photo_width, photo_height);
+							photo_pyramid.build(photo.data(), photo_width, photo_height, tiled_view_t::tile);
+						}
+						if (img->edited()) img->replace(photo, pic_width, pic_height, photo_pyramid); //the path goes on the photo itself
+						maze.grid = rectified_grid();
+						maze.width = maze.grid.width;
+						maze.height = maze.grid.height;
+						maze.start = rectification.rectified_point(start);
+						maze.end = rectification.rectified_point(end);
+						snap_to_open(maze.grid, maze.start);
+						snap_to_open(maze.grid, maze.end);
+						start = rectification.photo_point(maze.start);
+						end = rectification.photo_point(maze.end);
+					}
+					else {
+						img->draw_grid(current_grid());
+						maze.grid = current_grid();
+						if (roi.empty()) {
+							snap_to_open(maze.grid, start); //a point on a wall can't reach anything, so it moves to the nearest corridor
+							snap_to_open(maze.grid, end);
+							maze.start = start;
+							maze.end = end;
 						}
 						else {
-							for (int i = 0; i < ret.path.size(); ++i) {
-								const auto r = uint8_t((float)i / (float)ret.path.size() * 255.f);
-								points.push_back({ ret.path[i].x, ret.path[i].y, path_value ?
-									rgba_t{ r, 0, uint8_t(0xFF - r), (uint8_t)0xFF } :
-									rgba_t{ uint8_t(path_cols[0] * 255.f), uint8_t(path_cols[1] * 255.f), uint8_t(path_cols[2] * 255.f), 0xFF } });
-							}
+							maze = crop_maze(maze, roi); //snaps inside the roi
+							start = roi.to_image(maze.start);
+							end = roi.to_image(maze.end);
+						}
+					}
+					if (border_exit) maze.ends = open_border_cells(maze); //the roi's edge when there is one
+					const auto no_exits = border_exit && maze.ends.empty(); //an empty set would quietly mean the end point
+					auto too_large = false;
+					if (components_stale) {
+						too_large = !components.build(maze);
+						loops = (long long)components.count - euler_number(maze.grid);
+						components_stale = too_large;
+					}
+					auto ret = !no_exits && !too_large && components.restrict_to_reachable(maze) ? algo->solve(maze) : ret_t{ false };
+					if (rectify) {
+						ret.path = path_to_photo(ret.path, rectification, pic_width, pic_height);
+						ret.from = rectification.photo_point(ret.from);
+						ret.to = rectification.photo_point(ret.to);
+						if (cost_map) ret.cost_map = costs_to_photo(ret.cost_map, rectification, pic_width, pic_height);
+					}
+					else if (!roi.empty()) uncrop_result(ret, roi, pic_width, pic_height, cost_map);
+					if (show_components && !rectify && !too_large) {
+						if (roi.empty()) img->draw_image(components.colorize());
+						else img->draw_region(components.colorize(), roi.x, roi.y, roi.width, roi.height);
+					}
+					if (ret.solved) {
+						end = ret.to;
+						path_overlay.clear();
+						cost_overlay->clear();
+						if (cost_map) cost_overlay->set(std::move(ret.cost_map), pic_width, pic_height, cost_scale_t(cost_scale), cost_heat ? colormap_t::heat : colormap_t::gray);
+						else {
+							if (!show_components) img->darken_background();
+							const auto fixed = IM_COL32(int(path_cols[0] * 255.f), int(path_cols[1] * 255.f), int(path_cols[2] * 255.f), 0xFF);
+							path_overlay.set(ret.path, [&](const size_t i) {
+								const auto r = int((float)i / (float)ret.path.size() * 255.f);
+								return path_value ? IM_COL32(r, 0, 0xFF - r, 0xFF) : fixed;
+							});
 						}
-						img->darken_background();
-						img->draw_points(points);
 						solved = true;
 					}
-					else tinyfd_messageBox("alert", "no solution found", "info", "info", 1);
+					else tinyfd_messageBox("alert", too_large ? "maze too large to solve" : no_exits ? "no border exits" : "no solution found", "info", "info", 1);
 				}
 
 				if (solved) {
@@ -155,22 +425,99 @@ int main() {
 						size_t last_period = file_name.find_last_of(".");
 						std::string raw_name = file_name.substr(0, last_period);
 						raw_name += "_output.jpg";
-						const auto vec_image = img->get_image_data();
+						auto vec_image = img->get_image_data();
+						cost_overlay->burn(vec_image);
+						path_overlay.burn(vec_image, pic_width, pic_height);
 						stbi_write_jpg(raw_name.c_str(), pic_width, pic_height, 4, vec_image.data(), 100);
 					}
 				}
 
+				ImGui::SameLine();
+				if (ImGui::Button("save as .maze")) {
+					maze_t maze = { pic_width, pic_height, start, end };
+					maze.grid = current_grid();
+					size_t last_period = file_name.find_last_of(".");
+					std::string raw_name = file_name.substr(0, last_period);
+					raw_name += ".maze";
+					const binarization_t binarization = { threshold, binarize_method_t(binarize_method), window_radius, cleanup };
+					if (!maze_file_t::save(raw_name.c_str(), maze, binarization, source.luminance.pixels))
+						tinyfd_messageBox("alert", "could not save maze", "info", "info", 1);
+				}
+
+				ImGui::SameLine();
+				if (ImGui::Button("export flow field")) {
+					maze_t maze = { pic_width, pic_height, start, end };
+					maze.grid = current_grid();
+					img->draw_grid(maze.grid);
+					if (border_exit) maze.ends = open_border_cells(maze);
+					if (border_exit && maze.ends.empty()) tinyfd_messageBox("alert", "no border exits", "info", "info", 1);
+					else {
+						const auto field = distance_field{}.solve(maze, maze.goals());
+						size_t last_period = file_name.find_last_of(".");
+						std::string raw_name = file_name.substr(0, last_period);
+						raw_name += "_flow.bin";
+						if (!field.save(raw_name.c_str()))
+							tinyfd_messageBox("alert", "could not write flow field", "info", "info", 1);
+					}
+					solved = false;
+				}
+
 				ImGui::Separator();
 
-				ImGui::BeginChild("##maze display");
+				ImGui::BeginChild("##maze display", ImVec2(0, 0), false, ImGuiWindowFlags_NoScrollbar | ImGuiWindowFlags_NoScrollWithMouse);
 				if (pic_chosen) {
-					img->draw_markers(start, end, marker_size);
-					if (show_whole_image) {
-						const auto pos = ImGui::GetWindowPos();
-						const auto size = ImGui::GetWindowSize();
-						ImGui::GetCurrentContext()->CurrentWindow->DrawList->AddImage((void*)(intptr_t)picture, ImGui::GetCursorScreenPos(), ImVec2(pos.x + size.x - 5, pos.y + size.y - 5));
+					const auto view_origin = ImGui::GetCursorScreenPos();
+					const auto view_size = ImGui::GetContentRegionAvail();
+					auto& view = img->view();
+					if (fit_view) view.fit(view_size);
+					if (actual_size) view.zoom_to(1, { view_size.x / 2, view_size.y / 2 });
+					fit_view = actual_size = false;
+					ImGui::InvisibleButton("##view", { std::max(view_size.x, 1.f), std::max(view_size.y, 1.f) });
+					view.handle_input(view_origin, ImGui::IsItemHovered(), !drawing_roi && corners_placed == 4); //left drags are for those when on
+					view.draw(ImGui::GetCurrentContext()->CurrentWindow->DrawList, view_origin, view_size);
+
+					//screen to image coordinates, through whatever scale the image is shown at
+					const auto origin = view.image_origin(view_origin);
+					const auto scale_x = float(view.zoom), scale_y = scale_x;
+					const auto mouse = ImGui::GetIO().MousePos;
+					if (corners_placed < 4 && scale_x > 0 && scale_y > 0) {
+						const corner_t at = { (mouse.x - origin.x) / scale_x, (mouse.y - origin.y) / scale_y };
+						const auto over = at.x >= 0 && at.y >= 0 && at.x < pic_width && at.y < pic_height;
+						if (ImGui::IsWindowHovered() && over && ImGui::IsMouseClicked(0)) corners[corners_placed++] = at;
+						if (corners_placed == 4) {
+							rectification_t check;
+							corners = order_corners(corners);
+							rectify = rectification_t::make(corners, rectified_size, check);
+							rectified_stale = true;
+							if (!rectify) {
+								corners_placed = 0;
+								tinyfd_messageBox("alert", "three of the corners are in a line, pick them again", "info", "info", 1);
+							}
+						}
+					}
+					else if (drawing_roi && scale_x > 0 && scale_y > 0) {
+						const point_t at = { int((mouse.x - origin.x) / scale_x), int((mouse.y - origin.y) / scale_y) };
+						const auto over = at.x >= 0 && at.y >= 0 && at.x < int(pic_width) && at.y < int(pic_height);
+						if (ImGui::IsWindowHovered() && over && ImGui::IsMouseClicked(0)) roi_anchor = at;
+						if (roi_anchor.x >= 0) {
+							roi = roi_t::from_corners(roi_anchor, at, pic_width, pic_height);
+							components_stale = true;
+							if (!ImGui::IsMouseDown(0)) roi_anchor = { -1, -1 };
+						}
 					}
-					else ImGui::Image((void*)picture, ImVec2((float)pic_width, (float)pic_height));
+					const auto overlay = ImGui::GetCurrentContext()->CurrentWindow->DrawList;
+					if (solved) cost_overlay->draw(overlay, view_origin, view_size, view);
+					if (solved) path_overlay.draw(overlay, origin, scale_x, scale_y);
+					draw_marker(overlay, origin, scale_x, scale_y, start, marker_size, IM_COL32(0xFF, 0, 0, 0xFF));
+					draw_marker(overlay, origin, scale_x, scale_y, end, marker_size, IM_COL32(0, 0xFF, 0, 0xFF));
+					if (rectify || corners_placed < 4) {
+						auto screen = [&](const corner_t& c) { return ImVec2(origin.x + float(c.x) * scale_x, origin.y + float(c.y) * scale_y); };
+						for (int i = 0; i + 1 < corners_placed; ++i) overlay->AddLine(screen(corners[i]), screen(corners[i + 1]), IM_COL32(0, 200, 255, 255), 2.f);
+						if (corners_placed == 4) overlay->AddLine(screen(corners[3]), screen(corners[0]), IM_COL32(0, 200, 255, 255), 2.f);
+					}
+					if (!roi.empty() && !rectify)
+						overlay->AddRect(ImVec2(origin.x + roi.x * scale_x, origin.y + roi.y * scale_y),
+							ImVec2(origin.x + (roi.x + roi.width) * scale_x, origin.y + (roi.y + roi.height) * scale_y), IM_COL32(255, 200, 0, 255), 0.f, ImDrawCornerFlags_All, 2.f);
 				}
 				ImGui::EndChild();
 			}
@@ -187,6 +534,11 @@ int main() {
 		glfwSwapBuffers(window);
 	}
 
+	//everything holding gl objects goes while the context is still current
+	cost_overlay.reset();
+	img.reset();
+	gl_resources::shared().trim();
+
 	ImGui_ImplOpenGL3_Shutdown();
 	ImGui_ImplGlfw_Shutdown();
 	ImGui::DestroyContext();
@@ -0,0 +1,184 @@
+#pragma once
+#include "includes.hpp"
+#include "mapped_file.hpp"
+#include "thresholding.hpp"
+#include "morphology.hpp"
+#include <fstream>
+
+//.maze: a preprocessed maze that loads with no decode. a 4096 byte header page, then page-aligned sections:
+//  grid       height rows of stride u64 words, lsb first, 1 = open, exactly the bit_grid_t layout
+//  luminance  optional, width * height bytes, so the maze can be rebinarized at another threshold
+//  tiles      optional, one u32 open cell count per tile_size x tile_size tile, row-major, so readers can skip
+//             solid tiles without touching them
+//every field is little-endian and an offset of 0 means the section is absent. version 1 files end the header after
+//tiles_offset and read back as a global threshold with no cleanup
+struct maze_file_header_t {
+	uint32_t magic, version, width, height;
+	int32_t start_x, start_y, end_x, end_y;
+	int32_t threshold; //the threshold the grid was binarized at
+	uint32_t stride, tile_size, reserved;
+	uint64_t grid_offset, luminance_offset, tiles_offset;
+	uint32_t method, cleanup_op, cleanup_element; //a binarize_method_t, morph_op_t and morph_element_t
+	int32_t radius, cleanup_radius, padding;
+};
+static_assert(sizeof(maze_file_header_t) == 96, "maze file header must stay packed");
+
+//everything that turned the luminance into the stored grid, so the same settings give the same grid back
+struct binarization_t {
+	int threshold = 200; //the one otsu picked, for otsu
+	binarize_method_t method = binarize_method_t::global;
+	int radius = 0;
+	cleanup_t cleanup;
+};
+
+constexpr uint32_t maze_file_magic = 0x455a414d; //"MAZE"
+constexpr uint32_t maze_file_version = 2;
+constexpr size_t maze_file_page = 4096;
+constexpr unsigned maze_file_tile_size = 256;
+
+class maze_file_t {
+	mapped_file_t m_file;
+	maze_file_header_t m_header = {};
+
+	const uint64_t* grid_row(const size_t y) const { return (const uint64_t*)(m_file.data() + m_header.grid_offset) + y * m_header.stride; }
+
+public:
+	bool open(const char* filename) {
+		if (!m_file.open(filename) || m_file.size() < sizeof(m_header)) return false;
+		memcpy(&m_header, m_file.data(), sizeof(m_header));
+		if (m_header.magic != maze_file_magic || m_header.version < 1 || m_header.version > maze_file_version) return false;
+		if (m_header.version < 2) {
+			m_header.method = m_header.cleanup_op = m_header.cleanup_element = m_header.radius = 0;
+			m_header.cleanup_radius = cleanup_t().radius;
+		}
+		if (m_header.method > uint32_t(binarize_method_t::sauvola) || m_header.cleanup_op > uint32_t(morph_op_t::open_close) || m_header.cleanup_element > uint32_t(morph_element_t::diamond)) return false;
+		if (m_header.width == 0 || m_header.height == 0 || m_header.stride != (uint64_t(m_header.width) + 63) / 64) return false;
+		const auto cells = uint64_t(m_header.width) * m_header.height;
+		auto fits = [&](const uint64_t offset, const uint64_t bytes) { //written so a crafted offset can't wrap past the check
+			return offset % 8 == 0 && offset <= m_file.size() && bytes <= m_file.size() - offset;
+		};
+		if (!fits(m_header.grid_offset, uint64_t(m_header.stride) * 8 * m_header.height)) return false;
+		if (m_header.luminance_offset && !fits(m_header.luminance_offset, cells)) return false;
+		if (m_header.tiles_offset && (m_header.tile_size == 0 || !fits(m_header.tiles_offset, uint64_t(tiles_x()) * tiles_y() * 4))) return false;
+		return true;
+	}
+
+	unsigned width() const { return m_header.width; }
+	unsigned height() const { return m_header.height; }
+	int threshold() const { return m_header.threshold; }
+
+	binarization_t binarization() const {
+		binarization_t out;
+		out.threshold = m_header.threshold;
+		out.method = binarize_method_t(m_header.method);
+		out.radius = m_header.radius;
+		out.cleanup.op = morph_op_t(m_header.cleanup_op);
+		out.cleanup.element = morph_element_t(m_header.cleanup_element);
+		out.cleanup.radius = m_header.cleanup_radius;
+		return out;
+	}
+	point_t start() const { return { m_header.start_x, m_header.start_y }; }
+	point_t end() const { return { m_header.end_x, m_header.end_y }; }
+	bool has_luminance() const { return m_header.luminance_offset != 0; }
+	bool has_tiles() const { return m_header.tiles_offset != 0; }
+	unsigned tile_size() const { return m_header.tile_size; }
+	unsigned tiles_x() const { return m_header.width / m_header.tile_size + (m_header.width % m_header.tile_size != 0); } //no overflow for any tile_size
+	unsigned tiles_y() const { return m_header.height / m_header.tile_size + (m_header.height % m_header.tile_size != 0); }
+
+	uint32_t tile_open_cells(const unsigned tx, const unsigned ty) const {
+		return ((const uint32_t*)(m_file.data() + m_header.tiles_offset))[size_t(ty) * tiles_x() + tx];
+	}
+
+	const uint8_t* luminance_row(const size_t y) const { return m_file.data() + m_header.luminance_offset + y * m_header.width; }
+
+	//copies the w x h rectangle at (x, y), which must lie inside the maze, into out, which then starts at (0, 0). only
+	//the words under the rectangle are read, so pages of rows and columns outside it are never faulted in
+	void read_grid(const unsigned x, const unsigned y, const unsigned w, const unsigned h, bit_grid_t& out) const {
+		out = bit_grid_t(w, h);
+		const auto shift = x % 64;
+		const auto tail = w % 64 ? (uint64_t(1) << (w % 64)) - 1 : ~uint64_t(0);
+		parallel_for(h, [&](const size_t first_row, const size_t last_row) {
+			for (auto row = first_row; row < last_row; ++row) {
+				const auto in = grid_row(y + row) + x / 64;
+				const auto words_left = m_header.stride - x / 64;
+				auto dest = out.row(row);
+				if (shift == 0) memcpy(dest, in, out.stride * sizeof(uint64_t));
+				else for (size_t word = 0; word < out.stride; ++word) {
+					const auto high = word + 1 < words_left ? in[word + 1] << (64 - shift) : 0;
+					dest[word] = in[word] >> shift | high;
+				}
+				dest[out.stride - 1] &= tail;
+			}
+		});
+	}
+
+	void read_luminance(const unsigned x, const unsigned y, const unsigned w, const unsigned h, std::vector<uint8_t>& out) const {
+		out.resize(size_t(w) * h);
+		parallel_for(h, [&](const size_t first_row, const size_t last_row) {
+			for (auto row = first_row; row < last_row; ++row) memcpy(&out[row * w], luminance_row(y + row) + x, w);
+		});
+	}
+
+	//luminance may be empty; tiles are always written since they cost one u32 per 64k cells
+	static bool save(const char* filename, const maze_t& maze, const binarization_t& binarization, const std::vector<uint8_t>& luminance = {}) {
+		const auto& grid = maze.grid;
+		const auto align = [](const uint64_t offset) { return (offset + maze_file_page - 1) / maze_file_page * maze_file_page; };
+		const auto tile = maze_file_tile_size;
+		const auto tiles_x = (grid.width + tile - 1) / tile, tiles_y = (grid.height + tile - 1) / tile;
+
+		std::vector<uint32_t> tiles(size_t(tiles_x) * tiles_y, 0);
+		parallel_for(tiles_y, [&](const size_t first_tile_row, const size_t last_tile_row) {
+			for (auto ty = first_tile_row; ty < last_tile_row; ++ty)
+				for (auto y = ty * tile; y < std::min<size_t>((ty + 1) * tile, grid.height); ++y)
+					for (size_t word = 0; word < grid.stride; ++word) //tile_size is a multiple of 64, so words never straddle tiles
+						tiles[ty * tiles_x + word * 64 / tile] += unsigned(popcount64(grid.row(y)[word]));
+		});
+
+		maze_file_header_t header = {};
+		header.magic = maze_file_magic;
+		header.version = maze_file_version;
+		header.width = grid.width;
+		header.height = grid.height;
+		header.start_x = maze.start.x;
+		header.start_y = maze.start.y;
+		header.end_x = maze.end.x;
+		header.end_y = maze.end.y;
+		header.threshold = binarization.threshold;
+		header.method = uint32_t(binarization.method);
+		header.radius = binarization.radius;
+		header.cleanup_op = uint32_t(binarization.cleanup.op);
+		header.cleanup_element = uint32_t(binarization.cleanup.element);
+		header.cleanup_radius = binarization.cleanup.radius;
+		header.stride = unsigned(grid.stride);
+		header.tile_size = tile;
+		header.grid_offset = maze_file_page;
+		auto offset = align(header.grid_offset + grid.words.size() * sizeof(uint64_t));
+		if (!luminance.empty()) {
+			header.luminance_offset = offset;
+			offset = align(offset + luminance.size());
+		}
+		header.tiles_offset = offset;
+
+		std::ofstream file(filename, std::ios::binary);
+		if (!file) return false;
+		file.write((const char*)&header, sizeof(header));
+		file.seekp(std::streamoff(header.grid_offset)); //seeking past the end leaves a gap that reads back as zeroes
+		file.write((const char*)grid.words.data(), grid.words.size() * sizeof(uint64_t));
+		if (header.luminance_offset) {
+			file.seekp(std::streamoff(header.luminance_offset));
+			file.write((const char*)luminance.data(), luminance.size());
+		}
+		file.seekp(std::streamoff(header.tiles_offset));
+		file.write((const char*)tiles.data(), tiles.size() * sizeof(uint32_t));
+		return bool(file);
+	}
+};
+
+inline bool is_maze_file(const char* filename) {
+	FILE* file = fopen(filename, "rb");
+	if (!file) return false;
+	uint32_t magic = 0;
+	const auto read = fread(&magic, sizeof(magic), 1, file);
+	fclose(file);
+	return read == 1 && magic == maze_file_magic;
+}
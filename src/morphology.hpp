@@ -0,0 +1,145 @@
+#pragma once
+#include "includes.hpp"
+
+//erosion and dilation of the open cells, 64 pixels per word operation. jpeg noise leaves pinholes in walls, which
+//opening (erode then dilate) removes, and wall specks in corridors, which closing (dilate then erode) removes. the
+//radius has to stay below half the wall and corridor widths, or closing deletes thin walls and opening thin corridors
+enum class morph_op_t { none, open, close, open_close };
+enum class morph_element_t { square, cross, diamond };
+
+constexpr const char* morph_op_names[] = { "none", "open", "close", "open+close" };
+constexpr const char* morph_element_names[] = { "square", "cross", "diamond" };
+
+//one row with a fill word either side and its padding bits set to fill, so shifted reads need no edge cases.
+//outside the image counts as open for erosion and as wall for dilation, so the border never erodes or grows
+inline void morph_padded_row(const bit_grid_t& grid, const size_t y, const uint64_t fill, std::vector<uint64_t>& out) {
+	out.assign(grid.stride + 2, fill);
+	std::copy(grid.row(y), grid.row(y) + grid.stride, out.begin() + 1);
+	if (grid.width % 64) out[grid.stride] |= fill & ~((uint64_t(1) << (grid.width % 64)) - 1);
+}
+
+//bit x of the result is bit x + k of the row, for |k| < 64
+inline uint64_t morph_shifted(const uint64_t* padded, const size_t word, const int k) {
+	const auto w = padded + word + 1;
+	if (k > 0) return w[0] >> k | w[1] << (64 - k);
+	if (k < 0) return w[0] << -k | w[-1] >> (64 + k);
+	return w[0];
+}
+
+inline void morph_clear_padding(bit_grid_t& grid) {
+	if (grid.width % 64 == 0) return;
+	const auto tail = (uint64_t(1) << (grid.width % 64)) - 1;
+	for (unsigned y = 0; y < grid.height; ++y) grid.row(y)[grid.stride - 1] &= tail;
+}
+
+//and (erode) or or (dilate) of the pixels up to radius away along the row
+inline bit_grid_t morph_horizontal(const bit_grid_t& in, const int radius, const bool erode) {
+	bit_grid_t out(in.width, in.height);
+	const auto fill = erode ? ~uint64_t(0) : 0;
+	parallel_for(in.height, [&](const size_t first_row, const size_t last_row) {
+		std::vector<uint64_t> row;
+		for (auto y = first_row; y < last_row; ++y) {
+			morph_padded_row(in, y, fill, row);
+			for (size_t word = 0; word < in.stride; ++word) {
+				auto bits = row[word + 1];
+				for (int k = 1; k <= radius; ++k) {
+					if (erode) bits &= morph_shifted(row.data(), word, k) & morph_shifted(row.data(), word, -k);
+					else bits |= morph_shifted(row.data(), word, k) | morph_shifted(row.data(), word, -k);
+				}
+				out.row(y)[word] = bits;
+			}
+		}
+	});
+	morph_clear_padding(out);
+	return out;
+}
+
+//the same down the columns, whole words at a time
+inline bit_grid_t morph_vertical(const bit_grid_t& in, const int radius, const bool erode) {
+	bit_grid_t out(in.width, in.height);
+	parallel_for(in.height, [&](const size_t first_row, const size_t last_row) {
+		for (auto y = first_row; y < last_row; ++y) {
+			const auto first = y >= size_t(radius) ? y - radius : 0, last = std::min<size_t>(y + radius, in.height - 1);
+			auto dest = out.row(y);
+			std::copy(in.row(first), in.row(first) + in.stride, dest); //rows past the edge leave the result unchanged
+			for (auto other = first + 1; other <= last; ++other) {
+				const auto src = in.row(other);
+				for (size_t word = 0; word < in.stride; ++word) dest[word] = erode ? dest[word] & src[word] : dest[word] | src[word];
+			}
+		}
+	});
+	return out;
+}
+
+inline bit_grid_t morph_combine(bit_grid_t a, const bit_grid_t& b, const bool erode) {
+	for (size_t i = 0; i < a.words.size(); ++i) a.words[i] = erode ? a.words[i] & b.words[i] : a.words[i] | b.words[i];
+	return a;
+}
+
+inline bit_grid_t morph_apply(const bit_grid_t& in, const morph_element_t element, const int radius, const bool erode) {
+	if (radius <= 0) return in;
+	switch (element) {
+	case morph_element_t::square: //separable, a row pass then a column pass
+		return morph_vertical(morph_horizontal(in, radius, erode), radius, erode);
+	case morph_element_t::cross: //the union of two lines, so the meet (erode) or join (dilate) of the line passes
+		return morph_combine(morph_horizontal(in, radius, erode), morph_vertical(in, radius, erode), erode);
+	default: { //a diamond of radius r is r crosses of radius 1
+		auto out = in;
+		for (int i = 0; i < radius; ++i) out = morph_combine(morph_horizontal(out, 1, erode), morph_vertical(out, 1, erode), erode);
+		return out;
+	}
+	}
+}
+
+//radius is capped at 63, the furthest a shift can reach into the neighbouring word
+inline bit_grid_t erode(const bit_grid_t& grid, const morph_element_t element = morph_element_t::square, const int radius = 1) {
+	return morph_apply(grid, element, std::min(radius, 63), true);
+}
+
+inline bit_grid_t dilate(const bit_grid_t& grid, const morph_element_t element = morph_element_t::square, const int radius = 1) {
+	return morph_apply(grid, element, std::min(radius, 63), false);
+}
+
+struct cleanup_t {
+	morph_op_t op = morph_op_t::none;
+	morph_element_t element = morph_element_t::square;
+	int radius = 1;
+
+	bool operator==(const cleanup_t& other) const { return op == other.op && element == other.element && radius == other.radius; }
+	bool operator!=(const cleanup_t& other) const { return !(*this == other); }
+
+	bit_grid_t apply(const bit_grid_t& grid) const {
+		switch (op) {
+		case morph_op_t::open: return dilate(erode(grid, element, radius), element, radius);
+		case morph_op_t::close: return erode(dilate(grid, element, radius), element, radius);
+		case morph_op_t::open_close: return erode(dilate(dilate(erode(grid, element, radius), element, radius), element, radius), element, radius);
+		default: return grid;
+		}
+	}
+};
+
+//euler number of the open cells (components minus holes), counted from 2x2 windows (gray's method for 4-connected
+//cells): (windows with one open cell - windows with three + 2 * diagonal pairs) / 4. every hole is a wall island the
+//paths can go round on either side, so components - euler is the number of loops in the maze, and each noise speck in
+//a corridor adds one loop and two junctions
+inline long long euler_number(const bit_grid_t& grid) {
+	std::vector<long long> row_counts(grid.height + 1, 0);
+	parallel_for(grid.height + 1, [&](const size_t first_row, const size_t last_row) {
+		std::vector<uint64_t> upper, lower;
+		for (auto y = first_row; y < last_row; ++y) { //windows straddling rows y - 1 and y, rows outside the image are walls
+			if (y > 0) morph_padded_row(grid, y - 1, 0, upper);
+			else upper.assign(grid.stride + 2, 0);
+			if (y < grid.height) morph_padded_row(grid, y, 0, lower);
+			else lower.assign(grid.stride + 2, 0);
+			for (size_t word = 0; word <= grid.stride; ++word) { //one word past the row for windows straddling its last pixel
+				const auto a = morph_shifted(upper.data(), word, -1), b = upper[word + 1];
+				const auto c = morph_shifted(lower.data(), word, -1), d = lower[word + 1];
+				const auto odd = a ^ b ^ c ^ d;
+				const auto three = odd & ((a & b & (c | d)) | (c & d & (a | b)));
+				const auto diagonal = (a & d & ~b & ~c) | (b & c & ~a & ~d);
+				row_counts[y] += (long long)popcount64(odd & ~three) - (long long)popcount64(three) + 2 * (long long)popcount64(diagonal);
+			}
+		}
+	});
+	return std::accumulate(row_counts.begin(), row_counts.end(), 0ll) / 4;
+}
@@ -0,0 +1,99 @@
+#pragma once
+#include "includes.hpp"
+#include "image_kernels.hpp"
+#include "mapped_file.hpp"
+
+#include <cctype>
+
+//binary pbm (P4, 1 bit per pixel, 1 = black) and pgm (P5, 8 or 16 bits per pixel) read straight from a mapping
+struct netpbm_t {
+	mapped_file_t file;
+	char kind = 0; //'4' or '5'
+	unsigned width = 0, height = 0, maxval = 1;
+	const uint8_t* raster = nullptr;
+
+	size_t row_bytes() const { return kind == '4' ? (size_t(width) + 7) / 8 : size_t(width) * (maxval > 255 ? 2 : 1); }
+
+	bool open(const char* filename) {
+		if (!file.open(filename) || file.size() < 2) return false;
+		const auto data = file.data();
+		if (data[0] != 'P' || (data[1] != '4' && data[1] != '5')) return false;
+		kind = data[1];
+
+		size_t pos = 2;
+		auto next_number = [&](unsigned& out) {
+			while (pos < file.size() && (isspace(data[pos]) || data[pos] == '#')) {
+				if (data[pos] == '#') while (pos < file.size() && data[pos] != '\n') ++pos;
+				else ++pos;
+			}
+			if (pos >= file.size() || !isdigit(data[pos])) return false;
+			uint64_t value = 0;
+			while (pos < file.size() && isdigit(data[pos]) && value <= UINT_MAX) value = value * 10 + (data[pos++] - '0');
+			out = unsigned(value);
+			return value > 0 && value <= UINT_MAX;
+		};
+		if (!next_number(width) || !next_number(height)) return false;
+		if (kind == '5' && (!next_number(maxval) || maxval > 65535)) return false;
+		if (pos >= file.size() || !isspace(data[pos])) return false;
+		raster = data + pos + 1; //exactly one whitespace byte separates the header from the raster
+		return file.size() - (pos + 1) >= row_bytes() * height;
+	}
+
+	void to_grid(const int threshold, bit_grid_t& out) const { //pbm ignores the threshold, its bits already are the maze
+		out = bit_grid_t(width, height);
+		if (kind == '4') {
+			uint8_t open_bits[256]; //pbm rows are msb first with 1 = wall, grid words are lsb first with 1 = open
+			for (int b = 0; b < 256; ++b) {
+				uint8_t reversed = 0;
+				for (int i = 0; i < 8; ++i) reversed |= ((b >> i) & 1) << (7 - i);
+				open_bits[b] = uint8_t(~reversed);
+			}
+			const auto bytes = row_bytes();
+			const auto tail = width % 64 ? (uint64_t(1) << (width % 64)) - 1 : ~uint64_t(0);
+			parallel_for(height, [&](const size_t first_row, const size_t last_row) {
+				for (auto y = first_row; y < last_row; ++y) {
+					const auto in = raster + y * bytes;
+					auto row = out.row(y);
+					for (size_t word = 0; word < out.stride; ++word) {
+						uint64_t bits = 0;
+						for (size_t b = 0; b < 8 && word * 8 + b < bytes; ++b)
+							bits |= uint64_t(open_bits[in[word * 8 + b]]) << (b * 8);
+						row[word] = word + 1 == out.stride ? bits & tail : bits;
+					}
+				}
+			});
+			return;
+		}
+
+		const auto& kernels = image_kernels();
+		parallel_for(height, [&](const size_t first_row, const size_t last_row) {
+			std::vector<uint8_t> scaled;
+			for (auto y = first_row; y < last_row; ++y) {
+				if (maxval == 255) kernels.binarize_plane(raster + y * row_bytes(), out.row(y), width, threshold); //no copy at all
+				else {
+					scaled.resize(width);
+					luminance_row(y, scaled.data());
+					kernels.binarize_plane(scaled.data(), out.row(y), width, threshold);
+				}
+			}
+		});
+	}
+
+	void luminance_row(const size_t y, uint8_t* out) const { //scaled to 0-255, pbm walls are 0 and open cells 255
+		const auto in = raster + y * row_bytes();
+		for (size_t x = 0; x < width; ++x) {
+			if (kind == '4') out[x] = (in[x / 8] >> (7 - x % 8) & 1) ? 0x00 : 0xFF;
+			else if (maxval > 255) out[x] = uint8_t((unsigned(in[x * 2]) << 8 | in[x * 2 + 1]) * 255u / maxval);
+			else out[x] = uint8_t(in[x] * 255u / maxval);
+		}
+	}
+};
+
+inline bool is_netpbm_file(const char* filename) {
+	FILE* file = fopen(filename, "rb");
+	if (!file) return false;
+	char magic[2] = {};
+	const auto read = fread(magic, 1, 2, file);
+	fclose(file);
+	return read == 2 && magic[0] == 'P' && (magic[1] == '4' || magic[1] == '5');
+}
@@ -0,0 +1,68 @@
+#pragma once
+#include "includes.hpp"
+
+//things drawn over the maze rather than into its texture: the draw list is rebuilt every frame at whatever scale the
+//image is shown at, so moving a marker or showing a path never reads back or uploads the image
+
+//the solved path as straight runs of pixels. a 4-connected path turns every few pixels at most, so this is far fewer
+//primitives than pixels, and runs outside the visible part of the window are skipped when drawing
+struct path_overlay_t {
+	struct run_t {
+		point_t from, to; //inclusive, and every step between them is the same
+		ImU32 color;
+	};
+	std::vector<run_t> runs;
+
+	void clear() { runs.clear(); }
+
+	//color(i) is the colour of the i-th pixel of the path
+	template <typename F>
+	void set(const std::vector<point_t>& path, F&& color) {
+		runs.clear();
+		for (size_t i = 0; i < path.size(); ++i) {
+			const auto c = color(i);
+			if (!runs.empty()) {
+				auto& last = runs.back();
+				const auto step = point_t{ path[i].x - last.to.x, path[i].y - last.to.y };
+				const auto run_step = point_t{ (last.to.x > last.from.x) - (last.to.x < last.from.x), (last.to.y > last.from.y) - (last.to.y < last.from.y) };
+				const auto single = last.from == last.to;
+				const auto adjacent = std::abs(step.x) <= 1 && std::abs(step.y) <= 1;
+				if (c == last.color && adjacent && (single || step == run_step)) {
+					last.to = path[i];
+					continue;
+				}
+			}
+			runs.push_back({ path[i], path[i], c });
+		}
+	}
+
+	void draw(ImDrawList* list, const ImVec2 origin, const float scale_x, const float scale_y) const {
+		const auto clip_min = list->GetClipRectMin(), clip_max = list->GetClipRectMax();
+		const auto thickness = std::max(1.f, std::min(scale_x, scale_y));
+		for (const auto& run : runs) {
+			const ImVec2 low = { origin.x + std::min(run.from.x, run.to.x) * scale_x, origin.y + std::min(run.from.y, run.to.y) * scale_y };
+			const ImVec2 high = { origin.x + (std::max(run.from.x, run.to.x) + 1) * scale_x, origin.y + (std::max(run.from.y, run.to.y) + 1) * scale_y };
+			if (high.x < clip_min.x || high.y < clip_min.y || low.x > clip_max.x || low.y > clip_max.y) continue;
+			if (run.from.x == run.to.x || run.from.y == run.to.y) list->AddRectFilled(low, high, run.color); //covers its pixels exactly
+			else list->AddLine({ origin.x + (run.from.x + .5f) * scale_x, origin.y + (run.from.y + .5f) * scale_y },
+				{ origin.x + (run.to.x + .5f) * scale_x, origin.y + (run.to.y + .5f) * scale_y }, run.color, thickness);
+		}
+	}
+
+	//writes the path into a width x height image, for saving what is on screen
+	void burn(std::vector<rgba_t>& pixels, const unsigned width, const unsigned height) const {
+		for (const auto& run : runs) {
+			const point_t step = { (run.to.x > run.from.x) - (run.to.x < run.from.x), (run.to.y > run.from.y) - (run.to.y < run.from.y) };
+			const rgba_t color = { uint8_t(run.color >> IM_COL32_R_SHIFT), uint8_t(run.color >> IM_COL32_G_SHIFT), uint8_t(run.color >> IM_COL32_B_SHIFT), 0xFF };
+			for (auto p = run.from;; p = { p.x + step.x, p.y + step.y }) {
+				if (p.x >= 0 && p.y >= 0 && p.x < int(width) && p.y < int(height)) pixels[size_t(p.y) * width + p.x] = color;
+				if (p == run.to) break;
+			}
+		}
+	}
+};
+
+//a size x size image pixel square with its top left corner on at, like the markers drawn into the texture used to be
+inline void draw_marker(ImDrawList* list, const ImVec2 origin, const float scale_x, const float scale_y, const point_t at, const int size, const ImU32 color) {
+	list->AddRectFilled({ origin.x + at.x * scale_x, origin.y + at.y * scale_y }, { origin.x + (at.x + size) * scale_x, origin.y + (at.y + size) * scale_y }, color);
+}
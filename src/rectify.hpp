@@ -0,0 +1,280 @@
+#pragma once
+#include "includes.hpp"
+#include "image_loader.hpp"
+#include "components.hpp"
+
+#include <array>
+#include <cmath>
+
+//straightening photographed mazes: the maze's four corners in the photo are mapped onto a rectangle with a
+//homography, and the luminance is resampled onto that rectangle at a chosen size before it is binarized. a photo
+//taken at an angle comes out square, and a 12 megapixel one comes out small enough to solve quickly. the path found
+//on the rectangle is mapped back through the same homography and drawn on the photo
+
+struct corner_t {
+	double x, y;
+};
+
+using corners_t = std::array<corner_t, 4>; //top left, top right, bottom right, bottom left
+
+//a projective map of the plane: (x, y) goes to ((h0 x + h1 y + h2) / w, (h3 x + h4 y + h5) / w) with
+//w = h6 x + h7 y + h8
+struct homography_t {
+	std::array<double, 9> h = { { 1, 0, 0, 0, 1, 0, 0, 0, 1 } };
+
+	corner_t apply(const double x, const double y) const {
+		const auto w = h[6] * x + h[7] * y + h[8];
+		return { (h[0] * x + h[1] * y + h[2]) / w, (h[3] * x + h[4] * y + h[5]) / w };
+	}
+
+	homography_t inverse() const { //the adjugate; the scale it is off by doesn't matter
+		homography_t out;
+		out.h = { {
+			h[4] * h[8] - h[5] * h[7], h[2] * h[7] - h[1] * h[8], h[1] * h[5] - h[2] * h[4],
+			h[5] * h[6] - h[3] * h[8], h[0] * h[8] - h[2] * h[6], h[2] * h[3] - h[0] * h[5],
+			h[3] * h[7] - h[4] * h[6], h[1] * h[6] - h[0] * h[7], h[0] * h[4] - h[1] * h[3],
+		} };
+		return out;
+	}
+
+	//the map taking each corner of from onto the same corner of to, with h8 fixed at 1: eight equations in eight
+	//unknowns, solved by gaussian elimination. false when three of the corners are in a line
+	static bool from_quads(const corners_t& from, const corners_t& to, homography_t& out) {
+		double a[8][9] = {};
+		for (int i = 0; i < 4; ++i) {
+			const auto x = from[i].x, y = from[i].y, u = to[i].x, v = to[i].y;
+			const double rows[2][9] = { { x, y, 1, 0, 0, 0, -u * x, -u * y, u }, { 0, 0, 0, x, y, 1, -v * x, -v * y, v } };
+			std::copy_n(rows[0], 9, a[2 * i]);
+			std::copy_n(rows[1], 9, a[2 * i + 1]);
+		}
+		for (int column = 0; column < 8; ++column) {
+			auto pivot = column;
+			for (auto row = column + 1; row < 8; ++row)
+				if (std::fabs(a[row][column]) > std::fabs(a[pivot][column])) pivot = row;
+			if (std::fabs(a[pivot][column]) < 1e-12) return false;
+			std::swap(a[pivot], a[column]);
+			for (auto row = 0; row < 8; ++row) {
+				if (row == column) continue;
+				const auto factor = a[row][column] / a[column][column];
+				for (auto k = column; k < 9; ++k) a[row][k] -= factor * a[column][k];
+			}
+		}
+		for (int i = 0; i < 8; ++i) out.h[i] = a[i][8] / a[i][i];
+		out.h[8] = 1;
+		return true;
+	}
+};
+
+//puts four corners in the order corners_t expects, whatever order they were clicked in: sorted by angle around their
+//centre, then turned so the one nearest the top left comes first
+inline corners_t order_corners(corners_t corners) {
+	const auto cx = (corners[0].x + corners[1].x + corners[2].x + corners[3].x) / 4, cy = (corners[0].y + corners[1].y + corners[2].y + corners[3].y) / 4;
+	std::sort(corners.begin(), corners.end(), [&](const corner_t& a, const corner_t& b) { return std::atan2(a.y - cy, a.x - cx) < std::atan2(b.y - cy, b.x - cx); });
+	const auto first = std::min_element(corners.begin(), corners.end(), [](const corner_t& a, const corner_t& b) { return a.x + a.y < b.x + b.y; });
+	std::rotate(corners.begin(), first, corners.end());
+	return corners;
+}
+
+//the photo's corners, for when nothing has been picked yet
+inline corners_t image_corners(const unsigned width, const unsigned height) {
+	return { { { 0, 0 }, { double(width), 0 }, { double(width), double(height) }, { 0, double(height) } } };
+}
+
+struct rectification_t {
+	corners_t corners; //in the photo, pixel edges rather than centres
+	unsigned width = 0, height = 0; //of the rectangle
+	homography_t to_photo, to_rectified;
+
+	//the rectangle is as wide as the longer of the quad's top and bottom edges and as tall as the longer of its sides,
+	//scaled down so its longer side is at most max_side. false when the corners don't make a quad
+	static bool make(const corners_t& corners, const unsigned max_side, rectification_t& out) {
+		const auto length = [](const corner_t& a, const corner_t& b) { return std::hypot(a.x - b.x, a.y - b.y); };
+		const auto w = std::max(length(corners[0], corners[1]), length(corners[3], corners[2]));
+		const auto h = std::max(length(corners[0], corners[3]), length(corners[1], corners[2]));
+		if (w < 2 || h < 2) return false;
+		const auto scale = std::min(1., double(max_side) / std::max(w, h));
+		out.corners = corners;
+		out.width = std::max(1u, unsigned(std::lround(w * scale)));
+		out.height = std::max(1u, unsigned(std::lround(h * scale)));
+		if (!homography_t::from_quads(image_corners(out.width, out.height), corners, out.to_photo)) return false;
+		out.to_rectified = out.to_photo.inverse();
+		return true;
+	}
+
+	//the cell a photo pixel lands in, clamped onto the rectangle
+	point_t rectified_point(const point_t p) const {
+		const auto at = to_rectified.apply(p.x + .5, p.y + .5);
+		return { std::min(std::max(int(std::floor(at.x)), 0), int(width) - 1), std::min(std::max(int(std::floor(at.y)), 0), int(height) - 1) };
+	}
+
+	point_t photo_point(const point_t p) const {
+		const auto at = to_photo.apply(p.x + .5, p.y + .5);
+		return { int(std::floor(at.x)), int(std::floor(at.y)) };
+	}
+};
+
+//resamples the photo onto the rectangle, rows in parallel. every output pixel is the mean of taps x taps bilinear
+//samples spread over its footprint, with taps the rounded up shrink factor (at most 4), so thin walls fade instead of
+//vanishing between samples when a large photo is scaled down. along a row the homography's numerators and
+//denominator are linear, so each step is three adds and a divide
+inline luminance_image_t warp_luminance(const luminance_image_t& photo, const rectification_t& r) {
+	luminance_image_t out;
+	out.width = r.width;
+	out.height = r.height;
+	out.pixels.resize(size_t(r.width) * r.height);
+	if (photo.pixels.empty()) return out;
+	const auto shrink = std::max(double(photo.width) / r.width, double(photo.height) / r.height);
+	const auto taps = std::min(4, std::max(1, int(std::ceil(shrink - 1e-9))));
+	const auto& h = r.to_photo.h;
+	auto sample = [&](double x, double y) { //bilinear at a point in pixel-edge coordinates, clamped at the border
+		x = std::min(std::max(x - .5, 0.), photo.width - 1.);
+		y = std::min(std::max(y - .5, 0.), photo.height - 1.);
+		const auto x0 = unsigned(x), y0 = unsigned(y);
+		const auto x1 = std::min(x0 + 1, photo.width - 1), y1 = std::min(y0 + 1, photo.height - 1);
+		const auto fx = x - x0, fy = y - y0;
+		const auto top = photo.pixels[size_t(y0) * photo.width + x0] * (1 - fx) + photo.pixels[size_t(y0) * photo.width + x1] * fx;
+		const auto bottom = photo.pixels[size_t(y1) * photo.width + x0] * (1 - fx) + photo.pixels[size_t(y1) * photo.width + x1] * fx;
+		return top * (1 - fy) + bottom * fy;
+	};
+	parallel_for(r.height, [&](const size_t first_row, const size_t last_row) {
+		std::vector<double> sums(r.width);
+		for (auto y = first_row; y < last_row; ++y) {
+			std::fill(sums.begin(), sums.end(), 0.);
+			for (int ty = 0; ty < taps; ++ty) {
+				const auto sy = y + (ty + .5) / taps;
+				for (int tx = 0; tx < taps; ++tx) {
+					const auto sx = (tx + .5) / taps;
+					auto u = h[0] * sx + h[1] * sy + h[2], v = h[3] * sx + h[4] * sy + h[5], w = h[6] * sx + h[7] * sy + h[8];
+					for (unsigned x = 0; x < r.width; ++x, u += h[0], v += h[3], w += h[6]) sums[x] += sample(u / w, v / w);
+				}
+			}
+			for (unsigned x = 0; x < r.width; ++x) out.pixels[y * r.width + x] = uint8_t(std::min(255., sums[x] / (taps * taps) + .5));
+		}
+	});
+	return out;
+}
+
+//the maze's corners, found as the extreme points of its walls: the dark regions (at otsu's threshold) that don't touch
+//the photo's edge, which skips a dark table around the page, or all of them when none of those is big enough to be a
+//maze. of those, every region at least a sixteenth the size of the largest counts, since entrances in the corners
+//often split the outer wall, while text and specks stay out. the pixels with the smallest and largest x + y and
+//x - y are the corners, which holds while the maze is turned less than 45 degrees. runs on a copy shrunk to about 1024
+//pixels across, so the corners are good to a few photo pixels. false when there are no walls
+inline bool find_corners(const luminance_image_t& photo, corners_t& out) {
+	if (photo.width < 8 || photo.height < 8) return false;
+	const auto factor = std::max(1u, (std::max(photo.width, photo.height) + 1023) / 1024);
+	const auto w = photo.width / factor, h = photo.height / factor;
+	luminance_image_t small;
+	small.width = w;
+	small.height = h;
+	small.pixels.resize(size_t(w) * h);
+	parallel_for(h, [&](const size_t first_row, const size_t last_row) {
+		for (auto y = first_row; y < last_row; ++y)
+			for (size_t x = 0; x < w; ++x) {
+				unsigned sum = 0;
+				for (size_t dy = 0; dy < factor; ++dy)
+					for (size_t dx = 0; dx < factor; ++dx) sum += photo.pixels[(y * factor + dy) * photo.width + x * factor + dx];
+				small.pixels[y * w + x] = uint8_t(sum / (factor * factor));
+			}
+	});
+	source_image_t source;
+	source.assign(std::move(small));
+	const auto threshold = otsu_threshold(source.histogram);
+	maze_t walls = { w, h, { 0, 0 }, { 0, 0 }, bit_grid_t(w, h) }; //labelled as if the walls were the corridors
+	for (unsigned y = 0; y < h; ++y)
+		for (unsigned x = 0; x < w; ++x)
+			if (source.luminance.pixels[size_t(y) * w + x] <= threshold) walls.grid.set({ int(x), int(y) }, true);
+	components_t regions;
+	if (!regions.build(walls)) return false; //can't happen at about 1024 across
+
+	std::vector<size_t> sizes(size_t(w) * h, 0);
+	std::vector<bool> on_edge(sizes.size(), false);
+	for (size_t i = 0; i < regions.labels.size(); ++i)
+		if (regions.labels[i] != components_t::wall) ++sizes[regions.labels[i]];
+	auto mark_edge = [&](const unsigned x, const unsigned y) {
+		if (regions.label({ int(x), int(y) }) != components_t::wall) on_edge[regions.label({ int(x), int(y) })] = true;
+	};
+	for (unsigned x = 0; x < w; ++x) {
+		mark_edge(x, 0);
+		mark_edge(x, h - 1);
+	}
+	for (unsigned y = 0; y < h; ++y) {
+		mark_edge(0, y);
+		mark_edge(w - 1, y);
+	}
+	size_t largest_inner = 0, largest = 0;
+	for (size_t i = 0; i < sizes.size(); ++i) {
+		largest = std::max(largest, sizes[i]);
+		if (!on_edge[i]) largest_inner = std::max(largest_inner, sizes[i]);
+	}
+	const auto inner_only = largest_inner * 64 >= size_t(w) * h;
+	const auto biggest = inner_only ? largest_inner : largest;
+	if (biggest == 0) return false;
+	std::vector<bool> chosen(sizes.size(), false);
+	for (size_t i = 0; i < sizes.size(); ++i) chosen[i] = sizes[i] * 16 >= biggest && (!inner_only || !on_edge[i]);
+
+	long long best[4] = { LLONG_MAX, LLONG_MIN, LLONG_MIN, LLONG_MIN }; //min x + y, max x - y, max x + y, max y - x
+	point_t found[4] = {};
+	for (unsigned y = 0; y < h; ++y)
+		for (unsigned x = 0; x < w; ++x) {
+			const auto label = regions.labels[size_t(y) * w + x];
+			if (label == components_t::wall || !chosen[label]) continue;
+			const long long keys[4] = { (long long)x + y, (long long)x - y, (long long)x + y, (long long)y - x };
+			for (int corner = 0; corner < 4; ++corner)
+				if (corner == 0 ? keys[0] < best[0] : keys[corner] > best[corner]) {
+					best[corner] = keys[corner];
+					found[corner] = { int(x), int(y) };
+				}
+		}
+	for (int corner = 0; corner < 4; ++corner) //the outer edge of the corner pixel, in photo pixels
+		out[corner] = { double(found[corner].x + (corner == 1 || corner == 2)) * factor, double(found[corner].y + (corner >= 2)) * factor };
+	rectification_t check;
+	return rectification_t::make(out, 16, check);
+}
+
+//a path on the rectangle drawn onto the photo: each cell maps to the photo pixel under its centre, and consecutive
+//ones are joined with straight lines, since one cell covers several photo pixels when the photo was shrunk. a pixel
+//the path comes back to is kept once
+inline std::vector<point_t> path_to_photo(const std::vector<point_t>& path, const rectification_t& r, const unsigned photo_width, const unsigned photo_height) {
+	std::vector<point_t> out;
+	bit_grid_t drawn(photo_width, photo_height);
+	auto add = [&](const point_t p) {
+		if (p.x < 0 || p.y < 0 || p.x >= int(photo_width) || p.y >= int(photo_height) || drawn[p]) return;
+		drawn.set(p, true);
+		out.push_back(p);
+	};
+	for (size_t i = 0; i < path.size(); ++i) {
+		const auto to = r.photo_point(path[i]);
+		if (i == 0) {
+			add(to);
+			continue;
+		}
+		const auto from = r.photo_point(path[i - 1]);
+		const auto steps = std::max(std::abs(to.x - from.x), std::abs(to.y - from.y));
+		for (int step = 1; step <= steps; ++step)
+			add({ from.x + int(std::lround(double(to.x - from.x) * step / steps)), from.y + int(std::lround(double(to.y - from.y) * step / steps)) });
+	}
+	return out;
+}
+
+//a cost map on the rectangle spread over the photo, each photo pixel taking the cell under it; outside the quad
+//everything is unreached
+inline std::vector<unsigned> costs_to_photo(const std::vector<unsigned>& costs, const rectification_t& r, const unsigned photo_width, const unsigned photo_height) {
+	std::vector<unsigned> out(size_t(photo_width) * photo_height, UINT_MAX);
+	parallel_for(photo_height, [&](const size_t first_row, const size_t last_row) {
+		for (auto y = first_row; y < last_row; ++y)
+			for (size_t x = 0; x < photo_width; ++x) {
+				const auto at = r.to_rectified.apply(x + .5, y + .5);
+				if (!(at.x >= 0 && at.y >= 0 && at.x < r.width && at.y < r.height)) continue; //also drops points past the horizon
+				out[y * photo_width + x] = costs[size_t(at.y) * r.width + size_t(at.x)];
+			}
+	});
+	return out;
+}
+
+//the whole stage: rectifies photo's luminance into out and returns the mapping, or false when the corners don't make a quad
+inline bool rectify_photo(const luminance_image_t& photo, const corners_t& corners, const unsigned max_side, rectification_t& mapping, source_image_t& out) {
+	if (!rectification_t::make(corners, max_side, mapping)) return false;
+	out.assign(warp_luminance(photo, mapping));
+	return true;
+}
@@ -0,0 +1,81 @@
+#pragma once
+#include "includes.hpp"
+#include "endpoints.hpp"
+
+//solving only part of the image: a photo or a scan usually has a margin, a title or a page around the maze, and
+//searching that wastes time and memory and lets paths run around the outside of the maze. solvers get a maze cropped
+//to the region of interest, so every buffer they allocate is the size of the region, and the result is moved back
+struct roi_t {
+	unsigned x = 0, y = 0, width = 0, height = 0; //empty means the whole image
+
+	bool empty() const { return width == 0 || height == 0; }
+	bool contains(const point_t p) const { return p.x >= int(x) && p.y >= int(y) && p.x < int(x + width) && p.y < int(y + height); }
+	point_t to_local(const point_t p) const { return { p.x - int(x), p.y - int(y) }; }
+	point_t to_image(const point_t p) const { return { p.x + int(x), p.y + int(y) }; }
+
+	//the part that lies inside an image_width x image_height image
+	roi_t clipped(const unsigned image_width, const unsigned image_height) const {
+		if (x >= image_width || y >= image_height) return {};
+		return { x, y, std::min(width, image_width - x), std::min(height, image_height - y) };
+	}
+
+	//the rectangle with corners a and b, both included, clipped to the image
+	static roi_t from_corners(const point_t a, const point_t b, const unsigned image_width, const unsigned image_height) {
+		const auto clamp = [](const int v, const unsigned size) { return unsigned(std::min(std::max(v, 0), int(size) - 1)); };
+		const auto x0 = clamp(std::min(a.x, b.x), image_width), x1 = clamp(std::max(a.x, b.x), image_width);
+		const auto y0 = clamp(std::min(a.y, b.y), image_height), y1 = clamp(std::max(a.y, b.y), image_height);
+		return { x0, y0, x1 - x0 + 1, y1 - y0 + 1 };
+	}
+};
+
+//the box around the maze's walls, from how deep the first wall lies on every row and column seen from each side. each
+//side takes the depth a twentieth of the way up rather than the smallest, so a few specks or a stray label in the
+//margin don't widen it; the outer wall itself stays inside. the whole image when it has no walls
+inline roi_t maze_bounds(const bit_grid_t& grid) {
+	const roi_t whole = { 0, 0, grid.width, grid.height };
+	const auto no_wall = wall_profiles_t::no_wall;
+	const auto profiles = wall_profiles(grid);
+	unsigned inset[4];
+	for (int side = 0; side < 4; ++side) {
+		std::vector<unsigned> depths;
+		for (const auto depth : profiles.depth[side])
+			if (depth != no_wall) depths.push_back(depth);
+		if (depths.empty()) return whole;
+		std::nth_element(depths.begin(), depths.begin() + depths.size() / 20, depths.end());
+		inset[side] = depths[depths.size() / 20];
+	}
+	if (inset[0] + inset[1] >= grid.width || inset[2] + inset[3] >= grid.height) return whole;
+	return { inset[0], inset[2], grid.width - inset[0] - inset[1], grid.height - inset[2] - inset[3] };
+}
+
+//the part of maze inside roi, in its own coordinates. sources and goals outside it drop out, and start and end move
+//to the nearest open cell inside, so an entrance clicked in the margin still works
+inline maze_t crop_maze(const maze_t& maze, const roi_t& roi) {
+	maze_t out = { roi.width, roi.height, roi.to_local(maze.start), roi.to_local(maze.end), maze.grid.crop(roi.x, roi.y, roi.width, roi.height) };
+	for (const auto& p : maze.starts)
+		if (roi.contains(p)) out.starts.push_back(roi.to_local(p));
+	for (const auto& p : maze.ends)
+		if (roi.contains(p)) out.ends.push_back(roi.to_local(p));
+	snap_to_open(out.grid, out.start);
+	snap_to_open(out.grid, out.end);
+	return out;
+}
+
+//moves a result found on crop_maze(maze, roi) back onto the image_width x image_height image. the cost map only
+//grows back to the whole image when full_cost_map is set (outside the region everything is unreached), otherwise
+//it is dropped, since nothing but the cost map view reads it
+inline void uncrop_result(ret_t& ret, const roi_t& roi, const unsigned image_width, const unsigned image_height, const bool full_cost_map) {
+	for (auto& p : ret.path) p = roi.to_image(p);
+	ret.from = roi.to_image(ret.from);
+	ret.to = roi.to_image(ret.to);
+	if (!full_cost_map || ret.cost_map.size() != size_t(roi.width) * roi.height) {
+		ret.cost_map = {};
+		return;
+	}
+	std::vector<unsigned> cost_map(size_t(image_width) * image_height, UINT_MAX);
+	parallel_for(roi.height, [&](const size_t first_row, const size_t last_row) {
+		for (auto y = first_row; y < last_row; ++y)
+			std::copy_n(&ret.cost_map[y * roi.width], roi.width, &cost_map[(roi.y + y) * image_width + roi.x]);
+	});
+	ret.cost_map = std::move(cost_map);
+}
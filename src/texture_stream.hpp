@@ -0,0 +1,207 @@
+#pragma once
+#include "includes.hpp"
+#include "gl_resources.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+
+//uploads rectangles of rgba pixels into textures without stalling the frame. each upload is copied into one of a
+//ring of pixel buffer objects by a worker thread, and the gl thread only issues glTexSubImage2D from a buffer that
+//is already full, which lets the driver copy it in the background. with gl 4.4 (or ARB_buffer_storage) the buffers
+//are mapped once for good and a fence tells when the gl is done reading one; without it each buffer is orphaned
+//and mapped again for every upload, which any gl 2.1 stack can do. all the gl calls happen in push, pump and
+//cancel, on the thread that owns the context
+struct texture_stream_t {
+	static const size_t slot_bytes = 1 << 18; //the largest upload that goes through a buffer, a 256 x 256 tile
+	static const int slot_count = 32; //a buffer takes two pumps to come back, so this is about twice the uploads per frame
+
+	texture_stream_t() = default;
+	texture_stream_t(const texture_stream_t&) = delete;
+	texture_stream_t& operator=(const texture_stream_t&) = delete;
+
+	~texture_stream_t() {
+		if (m_worker.joinable()) {
+			cancel();
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				m_quit = true;
+			}
+			m_wake.notify_one();
+			m_worker.join();
+		}
+		for (auto& slot : m_slots) { //the buffers go back for reuse, so whatever still reads them has to finish
+			if (!slot.fence) continue;
+			glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, GLuint64(1000000000));
+			glDeleteSync(slot.fence);
+		}
+	}
+
+	//queues the w x h pixels, rows stride pixels apart, for (x, y) in texture. pixels are read by the worker until
+	//pump reports tag, or cancel, so they must stay alive and unchanged until then. uploads bigger than a buffer
+	//happen right away
+	void push(const GLuint texture, const unsigned x, const unsigned y, const unsigned w, const unsigned h, const rgba_t* pixels, const size_t stride, const uint64_t tag) {
+		if (size_t(w) * h * sizeof(rgba_t) > slot_bytes) {
+			glBindTexture(GL_TEXTURE_2D, texture);
+			glPixelStorei(GL_UNPACK_ROW_LENGTH, GLint(stride));
+			glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, w, h, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+			glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+			glBindTexture(GL_TEXTURE_2D, 0);
+			m_done.push_back(tag);
+			m_uploaded += size_t(w) * h * sizeof(rgba_t);
+			return;
+		}
+		if (!m_slots[0].buffer) create_buffers();
+		if (!m_worker.joinable()) m_worker = std::thread([this]() { work(); });
+		m_jobs.push_back({ texture, x, y, w, h, pixels, stride, tag });
+	}
+
+	//call once a frame: retires buffers the gl has finished with, uploads the ones that are full, and hands the free
+	//ones the next queued uploads. the tags of the uploads issued since the last pump are added to uploaded; their
+	//textures can be drawn from now on
+	void pump(std::vector<uint64_t>& uploaded) {
+		uploaded.insert(uploaded.end(), m_done.begin(), m_done.end());
+		m_done.clear();
+		for (auto& slot : m_slots) {
+			if (slot.state != in_flight) continue;
+			if (slot.fence) {
+				if (glClientWaitSync(slot.fence, 0, 0) == GL_TIMEOUT_EXPIRED) continue;
+				glDeleteSync(slot.fence);
+				slot.fence = nullptr;
+			}
+			slot.state = idle;
+		}
+
+		for (auto& slot : m_slots) {
+			if (slot.state != filled) continue;
+			const auto& job = slot.job;
+			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, slot.buffer.id());
+			if (!m_persistent) glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+			glBindTexture(GL_TEXTURE_2D, job.texture);
+			glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+			glTexSubImage2D(GL_TEXTURE_2D, 0, job.x, job.y, job.w, job.h, GL_RGBA, GL_UNSIGNED_BYTE, nullptr); //offset 0 into the buffer
+			glBindTexture(GL_TEXTURE_2D, 0);
+			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+			if (m_fences) slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+			slot.state = in_flight;
+			uploaded.push_back(job.tag);
+			m_uploaded += size_t(job.w) * job.h * sizeof(rgba_t);
+		}
+
+		for (auto& slot : m_slots) {
+			if (slot.state != idle || m_jobs.empty()) continue;
+			if (!m_persistent) { //orphans the old storage, so mapping never waits on an upload still reading it
+				glBindBuffer(GL_PIXEL_UNPACK_BUFFER, slot.buffer.id());
+				glBufferData(GL_PIXEL_UNPACK_BUFFER, slot_bytes, nullptr, GL_STREAM_DRAW);
+				slot.mapped = glMapBuffer(GL_PIXEL_UNPACK_BUFFER, GL_WRITE_ONLY);
+				glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+				if (!slot.mapped) continue;
+			}
+			slot.job = m_jobs.front();
+			m_jobs.pop_front();
+			slot.state = filling;
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				m_queue.push_back(&slot);
+			}
+			m_wake.notify_one();
+		}
+	}
+
+	//uploads queued or being copied, not counting ones already issued
+	size_t pending() const {
+		return m_jobs.size() + std::count_if(m_slots, m_slots + slot_count, [](const slot_t& s) { return s.state == filling || s.state == filled; });
+	}
+
+	//drops every upload not issued yet, waiting for the worker to let go of their pixels
+	void cancel() {
+		m_jobs.clear();
+		m_done.clear();
+		if (!m_worker.joinable()) return;
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			for (auto slot : m_queue) slot->state = filled; //never copied, but nothing will read it
+			m_queue.clear();
+			m_idle.wait(lock, [&]() { return !m_busy; });
+		}
+		for (auto& slot : m_slots) {
+			if (slot.state != filling && slot.state != filled) continue;
+			if (!m_persistent) {
+				glBindBuffer(GL_PIXEL_UNPACK_BUFFER, slot.buffer.id());
+				glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+				glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+			}
+			slot.state = idle;
+		}
+	}
+
+	bool persistent() const { return m_persistent; }
+	size_t uploaded_bytes() const { return m_uploaded; }
+
+private:
+	enum slot_state_t { idle, filling, filled, in_flight };
+	struct job_t {
+		GLuint texture;
+		unsigned x, y, w, h;
+		const rgba_t* pixels;
+		size_t stride;
+		uint64_t tag;
+	};
+	struct slot_t {
+		gl_buffer_t buffer;
+		void* mapped = nullptr;
+		GLsync fence = nullptr;
+		job_t job = {};
+		std::atomic<int> state{ idle };
+	};
+
+	slot_t m_slots[slot_count];
+	bool m_persistent = false, m_fences = false;
+	std::deque<job_t> m_jobs; //waiting for a free buffer
+	std::vector<uint64_t> m_done; //uploaded directly since the last pump
+	size_t m_uploaded = 0;
+
+	std::thread m_worker;
+	std::mutex m_mutex;
+	std::condition_variable m_wake, m_idle;
+	std::vector<slot_t*> m_queue; //buffers waiting for the worker
+	bool m_busy = false, m_quit = false;
+
+	void create_buffers() {
+		m_fences = GLEW_VERSION_3_2 || GLEW_ARB_sync;
+		m_persistent = m_fences && (GLEW_VERSION_4_4 || GLEW_ARB_buffer_storage);
+		auto& resources = gl_resources::shared();
+		if (m_persistent) {
+			for (auto& slot : m_slots) {
+				slot.buffer = resources.buffer(slot_bytes, true);
+				slot.mapped = slot.buffer.mapped();
+			}
+			if (std::all_of(m_slots, m_slots + slot_count, [](const slot_t& s) { return s.mapped != nullptr; })) return;
+			for (auto& slot : m_slots) { //advertised but refused, fall back to mapping every upload
+				slot.buffer = {};
+				slot.mapped = nullptr;
+			}
+			m_persistent = false;
+		}
+		for (auto& slot : m_slots) slot.buffer = resources.buffer(slot_bytes, false);
+	}
+
+	void work() { //copies each queued upload into its buffer, rows packed together
+		std::unique_lock<std::mutex> lock(m_mutex);
+		for (;;) {
+			m_wake.wait(lock, [&]() { return m_quit || !m_queue.empty(); });
+			if (m_quit) return;
+			const auto slot = m_queue.front();
+			m_queue.erase(m_queue.begin());
+			m_busy = true;
+			const auto job = slot->job;
+			lock.unlock();
+			for (unsigned row = 0; row < job.h; ++row)
+				memcpy((rgba_t*)slot->mapped + size_t(row) * job.w, job.pixels + row * job.stride, job.w * sizeof(rgba_t));
+			slot->state = filled;
+			lock.lock();
+			m_busy = false;
+			m_idle.notify_all();
+		}
+	}
+};
@@ -0,0 +1,87 @@
+#pragma once
+#include "includes.hpp"
+#include "morphology.hpp"
+#include "components.hpp"
+
+#include <array>
+
+//thins the open cells to a one pixel wide, 8-connected skeleton along the middle of every corridor (zhang-suen).
+//each pass peels one layer of boundary pixels whose removal can't split a corridor or shorten a dead end, in two
+//sub-iterations (south-east boundary, then north-west) so the skeleton stays centred. whether a pixel goes depends
+//only on its 3x3 neighbourhood, looked up in a 256 entry table, and every pixel of a sub-iteration reads the grid as it
+//was before it, so rows can be thinned in parallel. a component the thinning empties (a 2x2 block goes in one
+//sub-iteration) keeps its first cell, so every component still has some skeleton to snap to
+
+//neighbourhood code bits, clockwise from north: n, ne, e, se, s, sw, w, nw
+inline std::array<std::array<bool, 256>, 2> zhang_suen_tables() {
+	std::array<std::array<bool, 256>, 2> out;
+	for (int code = 0; code < 256; ++code) {
+		const auto bit = [code](const int i) { return (code >> (i % 8)) & 1; };
+		int neighbours = 0, transitions = 0;
+		for (int i = 0; i < 8; ++i) {
+			neighbours += bit(i);
+			transitions += !bit(i) && bit(i + 1);
+		}
+		const auto n = bit(0), e = bit(2), s = bit(4), w = bit(6);
+		const auto removable = neighbours >= 2 && neighbours <= 6 && transitions == 1;
+		out[0][code] = removable && !(n && e && s) && !(e && s && w);
+		out[1][code] = removable && !(n && e && w) && !(n && s && w);
+	}
+	return out;
+}
+
+inline bit_grid_t skeletonize(const bit_grid_t& grid) {
+	static const auto tables = zhang_suen_tables();
+	bit_grid_t in = grid, out = grid;
+	std::vector<size_t> removed(grid.height);
+	for (auto changed = true; changed;) { //until a whole pass removes nothing
+		changed = false;
+		for (const auto& table : tables) {
+			std::fill(removed.begin(), removed.end(), 0);
+			parallel_for(grid.height, [&](const size_t first_row, const size_t last_row) {
+				std::vector<uint64_t> up, here, down; //outside the image is wall
+				for (auto y = first_row; y < last_row; ++y) {
+					if (y > 0) morph_padded_row(in, y - 1, 0, up);
+					else up.assign(in.stride + 2, 0);
+					morph_padded_row(in, y, 0, here);
+					if (y + 1 < in.height) morph_padded_row(in, y + 1, 0, down);
+					else down.assign(in.stride + 2, 0);
+
+					for (size_t word = 0; word < in.stride; ++word) {
+						const auto bits = here[word + 1];
+						if (!bits) continue;
+						const uint64_t around[8] = {
+							up[word + 1], morph_shifted(up.data(), word, 1), morph_shifted(here.data(), word, 1), morph_shifted(down.data(), word, 1),
+							down[word + 1], morph_shifted(down.data(), word, -1), morph_shifted(here.data(), word, -1), morph_shifted(up.data(), word, -1),
+						};
+						auto inside = bits; //pixels with all eight neighbours open never go, so only the boundary is looked up
+						for (const auto neighbours : around) inside &= neighbours;
+						uint64_t remove = 0;
+						for (auto left = bits & ~inside; left; left &= left - 1) {
+							const auto x = ctz64(left);
+							unsigned code = 0;
+							for (int i = 0; i < 8; ++i) code |= unsigned((around[i] >> x) & 1) << i;
+							if (table[code]) remove |= uint64_t(1) << x;
+						}
+						out.row(y)[word] = bits & ~remove;
+						removed[y] += popcount64(remove);
+					}
+				}
+			});
+			if (std::any_of(removed.begin(), removed.end(), [](const size_t count) { return count != 0; })) {
+				changed = true;
+				in.words = out.words;
+			}
+		}
+	}
+
+	components_t components;
+	if (!components.build({ grid.width, grid.height, {}, {}, grid })) return out; //too many cells to label
+	std::vector<uint8_t> has_skeleton(components.labels.size(), 0); //by root cell
+	for (unsigned y = 0; y < out.height; ++y)
+		for (size_t word = 0; word < out.stride; ++word)
+			for (auto left = out.row(y)[word]; left; left &= left - 1) has_skeleton[components.labels[size_t(y) * grid.width + word * 64 + ctz64(left)]] = 1;
+	for (size_t i = 0; i < components.labels.size(); ++i)
+		if (components.labels[i] == i && !has_skeleton[i]) out.set({ int(i % grid.width), int(i / grid.width) }, true);
+	return out;
+}
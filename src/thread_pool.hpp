@@ -0,0 +1,105 @@
+#pragma once
+#include <algorithm>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//one set of worker threads shared by every whole-image pass, so a pass costs a wake-up instead of thread creation
+class thread_pool {
+	std::vector<std::thread> m_workers;
+	std::mutex m_mutex, m_run_mutex;
+	std::condition_variable m_wake, m_done;
+	const std::function<void(size_t)>* m_job = nullptr;
+	size_t m_jobs = 0, m_next = 0, m_pending = 0;
+	uint64_t m_generation = 0;
+	bool m_stop = false;
+
+	static bool& inside_pool() { //set while a thread runs a job, nested runs then stay on that thread
+		thread_local bool inside = false;
+		return inside;
+	}
+
+	void work() {
+		inside_pool() = true;
+		while (true) {
+			size_t job;
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				if (m_next >= m_jobs) break;
+				job = m_next++;
+			}
+			(*m_job)(job);
+			std::lock_guard<std::mutex> lock(m_mutex);
+			if (--m_pending == 0) m_done.notify_all();
+		}
+		inside_pool() = false;
+	}
+
+public:
+	explicit thread_pool(const size_t threads) {
+		for (size_t i = 1; i < threads; ++i) { //the calling thread is the last worker
+			m_workers.emplace_back([this] {
+				uint64_t seen = 0;
+				std::unique_lock<std::mutex> lock(m_mutex);
+				while (true) {
+					m_wake.wait(lock, [&] { return m_stop || (m_generation != seen && m_next < m_jobs); });
+					if (m_stop) return;
+					seen = m_generation;
+					lock.unlock();
+					work();
+					lock.lock();
+				}
+			});
+		}
+	}
+
+	~thread_pool() {
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_stop = true;
+		}
+		m_wake.notify_all();
+		for (auto& worker : m_workers) worker.join();
+	}
+
+	static thread_pool& shared() {
+		static thread_pool pool(std::max(1u, std::thread::hardware_concurrency()));
+		return pool;
+	}
+
+	size_t size() const { return m_workers.size() + 1; }
+
+	//runs job(0) .. job(jobs - 1) and returns once all are done. runs inline when called from inside a job or while
+	//another thread has the pool, so it can never deadlock
+	void run(const size_t jobs, const std::function<void(size_t)>& job) {
+		std::unique_lock<std::mutex> busy(m_run_mutex, std::try_to_lock);
+		if (!busy || inside_pool() || m_workers.empty() || jobs < 2) {
+			for (size_t i = 0; i < jobs; ++i) job(i);
+			return;
+		}
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_job = &job;
+			m_jobs = jobs;
+			m_next = 0;
+			m_pending = jobs;
+			++m_generation;
+		}
+		m_wake.notify_all();
+		work();
+		std::unique_lock<std::mutex> lock(m_mutex);
+		m_done.wait(lock, [this] { return m_pending == 0; });
+		m_job = nullptr;
+	}
+};
+
+//splits [0, count) into contiguous bands, a few per pool thread so uneven rows balance out, and runs fn(begin, end)
+//on each band
+template <typename F>
+void parallel_for(const size_t count, F&& fn) {
+	auto& pool = thread_pool::shared();
+	const auto bands = std::min(count, pool.size() * 4);
+	pool.run(bands, [&](const size_t band) { fn(count * band / bands, count * (band + 1) / bands); });
+}
@@ -0,0 +1,55 @@
+#pragma once
+#include "includes.hpp"
+
+//finds the highest binarize threshold at which start and end are joined by open pixels. lowering the threshold only
+//ever opens pixels, so adding pixels to a union-find from brightest to darkest visits every threshold in one pass
+struct threshold_sweep {
+	//a pixel is open when its luminance is above the threshold, so -1 means every pixel has to be open. pixels are
+	//32-bit indices here, so an image of more than too_large pixels gets too_large back instead of a wrapped answer
+	static constexpr int too_large = INT_MIN;
+
+	int find(const std::vector<uint8_t>& luminance, const unsigned width, const unsigned height, const point_t start, const point_t end) {
+		constexpr auto absent = UINT32_MAX;
+		const size_t cells = size_t(width) * height;
+		if (uint64_t(width) * height > absent) return too_large;
+
+		size_t offsets[257] = {}; //counting sort, brightest first
+		for (const auto l : luminance) ++offsets[255 - l + 1];
+		for (int i = 1; i <= 256; ++i) offsets[i] += offsets[i - 1];
+		std::vector<uint32_t> order(cells);
+		{
+			size_t next[256];
+			std::copy(offsets, offsets + 256, next);
+			for (size_t i = 0; i < cells; ++i) order[next[255 - luminance[i]]++] = uint32_t(i);
+		}
+
+		std::vector<uint32_t> parent(cells, absent);
+		auto find = [&parent](uint32_t i) {
+			while (parent[i] != i) {
+				parent[i] = parent[parent[i]];
+				i = parent[i];
+			}
+			return i;
+		};
+		auto unite = [&](const uint32_t a, const uint32_t b) {
+			const auto root_a = find(a), root_b = find(b);
+			if (root_a != root_b) parent[std::max(root_a, root_b)] = std::min(root_a, root_b);
+		};
+
+		const auto start_idx = uint32_t(size_t(start.y) * width + start.x), end_idx = uint32_t(size_t(end.y) * width + end.x);
+		for (int level = 255; level >= 0; --level) {
+			for (auto k = offsets[255 - level]; k < offsets[255 - level + 1]; ++k) {
+				const auto i = order[k];
+				const auto x = i % width, y = i / width;
+				parent[i] = i;
+				if (x > 0 && parent[i - 1] != absent) unite(i, i - 1);
+				if (x + 1 < width && parent[i + 1] != absent) unite(i, i + 1);
+				if (y > 0 && parent[i - width] != absent) unite(i, i - width);
+				if (y + 1 < height && parent[i + width] != absent) unite(i, i + width);
+			}
+			if (parent[start_idx] != absent && parent[end_idx] != absent && find(start_idx) == find(end_idx))
+				return level - 1;
+		}
+		return -1;
+	}
+};
@@ -0,0 +1,125 @@
+#pragma once
+#include "includes.hpp"
+
+#include <array>
+#include <cmath>
+
+//ways of turning luminance into open/wall cells. global compares every pixel with one threshold; otsu picks that
+//threshold from the histogram; bradley and sauvola compare each pixel with its neighbourhood, for photos where the
+//lighting changes across the frame
+enum class binarize_method_t { global, otsu, bradley, sauvola };
+
+constexpr const char* binarize_method_names[] = { "global", "otsu", "bradley", "sauvola" };
+
+//the threshold that best splits the histogram into two classes (max between-class variance). like every other
+//threshold, pixels above it are open
+inline int otsu_threshold(const std::array<uint64_t, 256>& histogram) {
+	uint64_t total = 0;
+	double total_sum = 0;
+	for (int value = 0; value < 256; ++value) {
+		total += histogram[value];
+		total_sum += double(value) * histogram[value];
+	}
+
+	uint64_t below = 0;
+	double below_sum = 0, best_variance = -1;
+	int best = 127;
+	for (int t = 0; t < 255; ++t) {
+		below += histogram[t];
+		below_sum += double(t) * histogram[t];
+		const auto above = total - below;
+		if (below == 0 || above == 0) continue;
+		const auto mean_below = below_sum / below, mean_above = (total_sum - below_sum) / above;
+		const auto variance = double(below) * double(above) * (mean_below - mean_above) * (mean_below - mean_above);
+		if (variance > best_variance) {
+			best_variance = variance;
+			best = t;
+		}
+	}
+	return best;
+}
+
+//a window about a sixteenth of the shorter side, the size bradley suggests; it has to be wider than the walls
+inline int default_window_radius(const unsigned width, const unsigned height) {
+	return std::max(8, int(std::min(width, height) / 16));
+}
+
+//calls open(pixel, sum, sum of squares, count) for the (2 * radius + 1)^2 window around every pixel, clipped to the
+//image. this is the integral image, just never stored whole: each band keeps running column sums for its window rows
+//and takes a prefix along each row, so every window is two subtractions and memory stays at a few rows per band
+template <bool squares, typename F>
+bit_grid_t local_binarize(const std::vector<uint8_t>& luminance, const unsigned width, const unsigned height, int radius, F&& open) {
+	bit_grid_t out(width, height);
+	if (radius <= 0) radius = default_window_radius(width, height);
+	const size_t r = std::min<size_t>(radius, std::max(width, height)); //a wider window is still the whole image
+
+	//one band per thread, since every band first has to sum the rows above its top edge
+	auto& pool = thread_pool::shared();
+	const auto bands = std::min<size_t>(height, pool.size());
+	pool.run(bands, [&](const size_t band) {
+		const size_t first_row = height * band / bands, last_row = height * (band + 1) / bands;
+		std::vector<uint32_t> column(width, 0);
+		std::vector<uint64_t> column_squares(squares ? width : 0, 0); //32 bits run out past 66051 rows
+		std::vector<uint64_t> prefix(width + 1, 0), prefix_squares(squares ? width + 1 : 0, 0);
+
+		auto add_row = [&](const size_t y, const bool add) {
+			const auto in = &luminance[y * width];
+			const uint32_t sign = add ? 1 : uint32_t(-1); //wraps, so the same loop adds or subtracts
+			for (size_t x = 0; x < width; ++x) column[x] += sign * in[x];
+			if (squares) for (size_t x = 0; x < width; ++x) column_squares[x] += (add ? 1 : uint64_t(-1)) * (uint32_t(in[x]) * in[x]);
+		};
+		for (auto y = first_row > r ? first_row - r : 0; y <= std::min<size_t>(first_row + r, height - 1); ++y) add_row(y, true);
+
+		for (auto y = first_row; y < last_row; ++y) {
+			for (size_t x = 0; x < width; ++x) {
+				prefix[x + 1] = prefix[x] + column[x];
+				if (squares) prefix_squares[x + 1] = prefix_squares[x] + column_squares[x];
+			}
+
+			const auto rows = std::min<size_t>(y + r, height - 1) - (y > r ? y - r : 0) + 1;
+			const auto in = &luminance[y * width];
+			auto row = out.row(y);
+			auto test = [&](const size_t x, const size_t left, const size_t right) {
+				const auto sum = prefix[right] - prefix[left];
+				const auto sum_squares = squares ? prefix_squares[right] - prefix_squares[left] : 0;
+				return uint64_t(open(in[x], sum, sum_squares, uint64_t(rows * (right - left)))) << (x % 64);
+			};
+			for (size_t word = 0; word < out.stride; ++word) {
+				const auto first = word * 64, last = std::min<size_t>(first + 64, width);
+				uint64_t bits = 0;
+				if (first >= r && last + r <= width) //the whole word's windows fit inside the row, no clipping needed
+					for (auto x = first; x < last; ++x) bits |= test(x, x - r, x + r + 1);
+				else for (auto x = first; x < last; ++x) bits |= test(x, x > r ? x - r : 0, std::min<size_t>(x + r + 1, width));
+				row[word] = bits;
+			}
+
+			if (y + 1 < last_row) {
+				if (y + r + 1 < height) add_row(y + r + 1, true);
+				if (y >= r) add_row(y - r, false);
+			}
+		}
+	});
+	return out;
+}
+
+//open when the pixel is brighter than (100 - percent)% of its window's mean
+inline bit_grid_t bradley_binarize(const std::vector<uint8_t>& luminance, const unsigned width, const unsigned height, const int radius = 0, const int percent = 15) {
+	return local_binarize<false>(luminance, width, height, radius, [percent](const uint32_t p, const uint64_t sum, uint64_t, const uint64_t count) {
+		return p * count * 100 > sum * uint64_t(100 - percent);
+	});
+}
+
+//open when the pixel is above mean * (1 + k * (deviation / 128 - 1)), so flat regions need less contrast than busy ones.
+//rearranged as p - mean * (1 - k) > mean * k / 128 * deviation and squared, all scaled by count, so there is no
+//division or square root per pixel
+inline bit_grid_t sauvola_binarize(const std::vector<uint8_t>& luminance, const unsigned width, const unsigned height, const int radius = 0, const double k = 0.2) {
+	return local_binarize<true>(luminance, width, height, radius, [k](const uint32_t p, const uint64_t sum, const uint64_t sum_squares, const uint64_t count) {
+		const auto excess = double(p) * count - double(sum) * (1. - k);
+		if (excess <= 0) return false;
+		const auto scale = double(sum) * k / 128.;
+		//count^2 times the variance, which outgrows 64 bits once a black and white window is some 5800 pixels wide, so it
+		//is taken in double, where rounding stays far below the sides being compared
+		const auto variance = std::max(0., double(sum_squares) * double(count) - double(sum) * double(sum));
+		return excess * excess * double(count) * double(count) > scale * scale * variance;
+	});
+}
@@ -0,0 +1,276 @@
+#pragma once
+#include "includes.hpp"
+#include "texture_stream.hpp"
+
+#include <list>
+#include <unordered_map>
+
+//the image at every power of two below full size, each level a box filter of the one above, down to one that fits a
+//single tile. levels[0] is half size; full size is the image itself, which the pyramid doesn't keep
+struct image_pyramid_t {
+	struct level_t {
+		unsigned width = 0, height = 0;
+		std::vector<rgba_t> pixels;
+	};
+	std::vector<level_t> levels;
+
+	void build(const rgba_t* image, const unsigned width, const unsigned height, const unsigned tile) {
+		levels.clear();
+		for (auto w = width, h = height; w > tile || h > tile;) {
+			w = (w + 1) / 2;
+			h = (h + 1) / 2;
+			levels.push_back({ w, h, std::vector<rgba_t>(size_t(w) * h) });
+		}
+		update(image, width, height, 0, 0, width, height);
+	}
+
+	//redoes the part of every level that [x0, x1) x [y0, y1) of the image averages into
+	void update(const rgba_t* image, const unsigned width, const unsigned height, unsigned x0, unsigned y0, unsigned x1, unsigned y1) {
+		auto above = image;
+		auto above_width = width, above_height = height;
+		for (auto& level : levels) {
+			x0 /= 2;
+			y0 /= 2;
+			x1 = std::min((x1 + 1) / 2, level.width);
+			y1 = std::min((y1 + 1) / 2, level.height);
+			parallel_for(y1 - y0, [&](const size_t first_row, const size_t last_row) {
+				for (auto y = y0 + first_row; y < y0 + last_row; ++y) {
+					const auto top = above + 2 * y * above_width, bottom = above + std::min<size_t>(2 * y + 1, above_height - 1) * above_width;
+					const auto out = (uint32_t*)&level.pixels[y * level.width];
+					for (auto x = x0; x < x1; ++x) {
+						const auto left = 2 * size_t(x), right = std::min<size_t>(2 * x + 1, above_width - 1); //odd sizes repeat the last column
+						uint32_t p[4];
+						memcpy(&p[0], &top[left], 4);
+						memcpy(&p[1], &top[right], 4);
+						memcpy(&p[2], &bottom[left], 4);
+						memcpy(&p[3], &bottom[right], 4);
+						//two channels per 16 bit lane, four of them sum to at most 1020
+						auto even = uint32_t(0x00020002), odd = uint32_t(0x00020002);
+						for (const auto v : p) {
+							even += v & 0x00FF00FF;
+							odd += (v >> 8) & 0x00FF00FF;
+						}
+						out[x] = ((even >> 2) & 0x00FF00FF) | (((odd >> 2) & 0x00FF00FF) << 8);
+					}
+				}
+			});
+			above = level.pixels.data();
+			above_width = level.width;
+			above_height = level.height;
+		}
+	}
+};
+
+//the image on screen at any size, even past GL_MAX_TEXTURE_SIZE. it is cut into tile x tile squares at every level
+//of its pyramid, and only the squares visible at the level that matches the zoom are textures, up to budget_bytes,
+//with the least recently drawn dropped first. squares are uploaded through a texture_stream_t, and until one is in
+//the nearest coarser level that is stands in for it
+struct tiled_view_t {
+	static const unsigned tile = 256;
+	static const int uploads_per_frame = 32; //tiles queued by one draw, the rest wait for later frames
+	size_t budget_bytes = size_t(256) << 20;
+
+	double zoom = 1; //screen pixels per image pixel
+	double x = 0, y = 0; //the image point at the top left of the view
+
+	tiled_view_t() = default;
+	tiled_view_t(const tiled_view_t&) = delete;
+	tiled_view_t& operator=(const tiled_view_t&) = delete;
+
+	~tiled_view_t() { clear(); }
+
+	//shows width x height pixels, which must stay alive until the next set_image. a pyramid already built for them
+	//can be handed over, otherwise one is built here
+	void set_image(const rgba_t* pixels, const unsigned width, const unsigned height, image_pyramid_t pyramid = {}) {
+		clear();
+		m_image = pixels;
+		m_width = width;
+		m_height = height;
+		m_pyramid = std::move(pyramid);
+		if (m_pyramid.levels.empty() && (width > tile || height > tile)) m_pyramid.build(pixels, width, height, tile);
+	}
+
+	//the image changed inside [x0, x1) x [y0, y1). the levels below are redone, and the tiles over it keep showing
+	//what they had until they are uploaded again
+	void invalidate(const unsigned x0, const unsigned y0, const unsigned x1, const unsigned y1) {
+		cancel_uploads();
+		m_pyramid.update(m_image, m_width, m_height, x0, y0, x1, y1);
+		for (auto& entry : m_resident) {
+			const auto level = unsigned(entry.first >> 48), tx = unsigned(entry.first & 0xFFFFFF), ty = unsigned((entry.first >> 24) & 0xFFFFFF);
+			const auto size = tile << level; //image pixels across a tile of this level
+			if (tx * size < x1 && (tx + 1) * size > x0 && ty * size < y1 && (ty + 1) * size > y0) entry.second.stale = true;
+		}
+	}
+
+	const image_pyramid_t& pyramid() const { return m_pyramid; }
+
+	//stops uploads that read the image, before it is written to
+	void cancel_uploads() {
+		m_stream.cancel();
+		for (auto& entry : m_resident) {
+			if (!entry.second.uploading) continue;
+			entry.second.uploading = false;
+			entry.second.stale = true;
+		}
+	}
+
+	//scrolls and zooms from the mouse over the view at origin. the wheel zooms about the pointer; dragging with the
+	//right or middle button pans, and so does the left one when pan_with_left
+	void handle_input(const ImVec2 origin, const bool hovered, const bool pan_with_left) {
+		const auto& io = ImGui::GetIO();
+		if (hovered && io.MouseWheel != 0) zoom_to(zoom * std::pow(1.25, io.MouseWheel), { io.MousePos.x - origin.x, io.MousePos.y - origin.y });
+		if (hovered && (ImGui::IsMouseClicked(1) || ImGui::IsMouseClicked(2) || (pan_with_left && ImGui::IsMouseClicked(0)))) m_panning = true;
+		if (!ImGui::IsMouseDown(0) && !ImGui::IsMouseDown(1) && !ImGui::IsMouseDown(2)) m_panning = false;
+		if (m_panning) {
+			x -= io.MouseDelta.x / zoom;
+			y -= io.MouseDelta.y / zoom;
+		}
+	}
+
+	//changes the zoom keeping the image point under about, a point in the view, where it is
+	void zoom_to(const double new_zoom, const ImVec2 about) {
+		const auto at_x = x + about.x / zoom, at_y = y + about.y / zoom;
+		zoom = std::min(std::max(new_zoom, 1. / 4096), 64.);
+		x = at_x - about.x / zoom;
+		y = at_y - about.y / zoom;
+	}
+
+	//the whole image, centred in a view of size
+	void fit(const ImVec2 size) {
+		if (!m_width || !m_height || size.x <= 0 || size.y <= 0) return;
+		zoom = std::min(size.x / m_width, size.y / m_height);
+		x = (m_width - size.x / zoom) / 2;
+		y = (m_height - size.y / zoom) / 2;
+	}
+
+	//where image point (0, 0) lands on screen, for drawing over the image at zoom pixels per image pixel
+	ImVec2 image_origin(const ImVec2 origin) const { return { float(origin.x - x * zoom), float(origin.y - y * zoom) }; }
+
+	//draws the part of the image in the size view at origin, and queues the tiles it still needs
+	void draw(ImDrawList* list, const ImVec2 origin, const ImVec2 size) {
+		++m_frame;
+		m_uploaded.clear();
+		m_stream.pump(m_uploaded);
+		for (const auto key : m_uploaded) {
+			const auto found = m_resident.find(key);
+			if (found == m_resident.end() || !found->second.uploading) continue;
+			found->second.uploading = false;
+			found->second.drawable = true;
+		}
+		if (!m_image || zoom <= 0) return;
+
+		auto level = 0;
+		while (level < int(m_pyramid.levels.size()) && zoom * (2 << level) <= 1) ++level; //the finest level with no more than a pixel per screen pixel
+		const auto size_at = [&](const int l) { return l == 0 ? std::make_pair(m_width, m_height) : std::make_pair(m_pyramid.levels[l - 1].width, m_pyramid.levels[l - 1].height); };
+		const auto level_size = size_at(level);
+		const auto scale = double(1 << level); //image pixels per level pixel
+		const auto columns = (level_size.first + tile - 1) / tile, rows = (level_size.second + tile - 1) / tile;
+		const auto clamp = [](const double t, const unsigned count) { return unsigned(std::min(std::max(t, 0.), double(count))); };
+		const auto tx0 = clamp(std::floor(x / scale / tile), columns), tx1 = clamp(std::ceil((x + size.x / zoom) / scale / tile), columns);
+		const auto ty0 = clamp(std::floor(y / scale / tile), rows), ty1 = clamp(std::ceil((y + size.y / zoom) / scale / tile), rows);
+		const auto screen = [&](const double image_x, const double image_y) { return ImVec2(float(origin.x + (image_x - x) * zoom), float(origin.y + (image_y - y) * zoom)); };
+
+		auto queued = 0;
+		for (auto ty = ty0; ty < ty1; ++ty)
+			for (auto tx = tx0; tx < tx1; ++tx) {
+				//the part of the image this tile covers, in image pixels
+				const auto w = std::min(tile, level_size.first - tx * tile), h = std::min(tile, level_size.second - ty * tile);
+				const auto low = screen(tx * tile * scale, ty * tile * scale);
+				const auto high = screen((tx * tile + w) * scale, (ty * tile + h) * scale);
+				const auto entry = request(level, tx, ty, w, h, queued);
+				if (entry && entry->drawable) {
+					list->AddImage((void*)(intptr_t)entry->texture.id(), low, high, { 0, 0 }, { float(w) / tile, float(h) / tile });
+					continue;
+				}
+				for (auto coarser = level + 1; coarser <= int(m_pyramid.levels.size()); ++coarser) { //stand-in
+					const auto shift = coarser - level;
+					const auto cx = (tx * tile >> shift) / tile, cy = (ty * tile >> shift) / tile;
+					const auto found = m_resident.find(key(coarser, cx, cy));
+					if (found == m_resident.end() || !found->second.drawable) continue;
+					touch(found->second);
+					const auto span = float(tile) / (1 << shift); //this tile's width within the coarser one, in its pixels
+					const auto u = float(tx * tile) / (1 << shift) - cx * tile, v = float(ty * tile) / (1 << shift) - cy * tile;
+					list->AddImage((void*)(intptr_t)found->second.texture.id(), low, high, { u / tile, v / tile },
+						{ (u + span * w / tile) / tile, (v + span * h / tile) / tile });
+					break;
+				}
+			}
+		evict();
+	}
+
+	size_t resident_tiles() const { return m_resident.size(); }
+	size_t resident_bytes() const { return m_resident.size() * tile_bytes; }
+	size_t uploaded_bytes() const { return m_stream.uploaded_bytes(); }
+	bool persistent_buffers() const { return m_stream.persistent(); }
+
+private:
+	static const size_t tile_bytes = size_t(tile) * tile * sizeof(rgba_t);
+
+	struct resident_t {
+		gl_texture_t texture;
+		bool drawable = false, uploading = false, stale = false;
+		unsigned last_frame = 0;
+		std::list<uint64_t>::iterator lru;
+	};
+
+	const rgba_t* m_image = nullptr;
+	unsigned m_width = 0, m_height = 0;
+	image_pyramid_t m_pyramid;
+	texture_stream_t m_stream;
+	std::unordered_map<uint64_t, resident_t> m_resident;
+	std::list<uint64_t> m_lru; //most recently drawn first
+	std::vector<uint64_t> m_uploaded;
+	unsigned m_frame = 0;
+	bool m_panning = false;
+
+	static uint64_t key(const int level, const unsigned tx, const unsigned ty) { return uint64_t(level) << 48 | uint64_t(ty) << 24 | tx; }
+
+	void touch(resident_t& entry) {
+		entry.last_frame = m_frame;
+		m_lru.splice(m_lru.begin(), m_lru, entry.lru);
+	}
+
+	//the tile, made resident and queued for upload if it isn't, or nullptr when this frame has no uploads left
+	resident_t* request(const int level, const unsigned tx, const unsigned ty, const unsigned w, const unsigned h, int& queued) {
+		const auto k = key(level, tx, ty);
+		auto found = m_resident.find(k);
+		if (found == m_resident.end()) {
+			if (queued >= uploads_per_frame) return nullptr;
+			resident_t entry;
+			entry.stale = true;
+			entry.texture = gl_resources::shared().texture(tile, tile);
+			m_lru.push_front(k);
+			entry.lru = m_lru.begin();
+			found = m_resident.emplace(k, std::move(entry)).first;
+		}
+		auto& entry = found->second;
+		touch(entry);
+		if (entry.stale && !entry.uploading && queued < uploads_per_frame) {
+			const auto pixels = level == 0 ? m_image : m_pyramid.levels[level - 1].pixels.data();
+			const auto stride = level == 0 ? m_width : m_pyramid.levels[level - 1].width;
+			m_stream.push(entry.texture.id(), 0, 0, w, h, pixels + size_t(ty) * tile * stride + size_t(tx) * tile, stride, k);
+			entry.stale = false;
+			entry.uploading = true;
+			++queued;
+		}
+		return &entry;
+	}
+
+	//drops the least recently drawn tiles while over budget, never ones drawn this frame or still uploading
+	void evict() {
+		for (auto it = m_lru.end(); m_resident.size() * tile_bytes > budget_bytes && it != m_lru.begin();) {
+			--it;
+			auto& entry = m_resident.at(*it);
+			if (entry.last_frame == m_frame) break; //everything before it was drawn this frame too
+			if (entry.uploading) continue;
+			m_resident.erase(*it); //its texture goes back to gl_resources
+			it = m_lru.erase(it);
+		}
+	}
+
+	void clear() {
+		m_stream.cancel(); //nothing may upload into the textures once they are given back
+		m_resident.clear();
+		m_lru.clear();
+	}
+};